@@ -9,6 +9,8 @@
  */
 
 #pragma once
+#include <atomic>
+#include <cstdint>
 #include <memory>
 #include <string>
 #include <vector>
@@ -18,7 +20,8 @@ namespace coco
 
 /*! \brief Specify the policy of the connection between two ports.
  *  For every connection there is a policy specifying the buffer type,
- *  the lock type and the transport type. Connections are always non blocking.
+ *  the lock type and the transport type. Connections are non blocking unless the
+ *  \ref BLOCK overflow policy is used.
  */
 struct ConnectionPolicy
 {
@@ -27,8 +30,10 @@ struct ConnectionPolicy
     enum BufferPolicy
     {
         DATA,      //!< Buffer of lenght 1. Incoming data always override existing one.
-        BUFFER,    //!< Buffer of lenght \ref buffer_size. If the buffer is full new data is discarded.
-        CIRCULAR   //!< Circular FIFO buffer of lenght \ref buffer_size. If the buffer is full new data overrides the oldest one.
+        BUFFER,    //!< Buffer of lenght \ref buffer_size. If the buffer is full the \ref overflow policy is applied.
+        CIRCULAR,  //!< Circular FIFO buffer of lenght \ref buffer_size. If the buffer is full new data overrides the oldest one.
+        WORK_QUEUE //!< Lock free buffer of lenght \ref buffer_size shared by all the WORK_QUEUE connections of the output port.
+                   //!< Each data is read by only one of the input ports, the first that asks for it.
     };
     /*! \brief Lock policy for concurrent access management.
      */
@@ -36,14 +41,23 @@ struct ConnectionPolicy
     {
         UNSYNC,    //!< No resource access control policy
         LOCKED,    //!< Data access is regulated by mutexes
-        LOCK_FREE  //!< NOT IMPLEMENTED YET (TBD)
+        LOCK_FREE  //!< Single producer single consumer lock free queues, wait-free triple buffer for \ref DATA
     };
     /*! \brief Specifies if the connection is between two threads or between processes.
      */
     enum Transport
     {
         LOCAL,  //!< Connection between two thread of the same process. Communication using shared memory.
-        IPC     //!< NOT IMPLEMENTED YET (TBD)
+        IPC     //!< Connection between two processes. Communication using a POSIX shared memory ring buffer.
+    };
+    /*! \brief Behaviour of a \ref BUFFER connection when data is written and the buffer is full.
+     */
+    enum OverflowPolicy
+    {
+        FAIL,         //!< New data is discarded and the write returns false.
+        DROP_NEWEST,  //!< New data is discarded but the write succeeds, the writer is not notified.
+        DROP_OLDEST,  //!< The oldest data is discarded to make room for the new one, as in \ref CIRCULAR.
+        BLOCK         //!< The writer waits up to \ref overflow_timeout ms for room, then it behaves as \ref FAIL.
     };
 
     BufferPolicy data_policy;
@@ -51,7 +65,11 @@ struct ConnectionPolicy
     int buffer_size;  //!< Size of the buffer
     bool init = false;
     Transport transport;
-    // std::string name_id;
+    std::string name_id;  //!< Unique name of the connection. Used by \ref IPC to identify the shared memory segment.
+    bool broadcast = false;  //!< The output port shares a single read-only sample with all the broadcast connections instead of copying data in each of them.
+    OverflowPolicy overflow = FAIL;  //!< What to do when a \ref BUFFER connection is full.
+    int overflow_timeout = 0;  //!< Maximum time in ms a writer is blocked with \ref BLOCK overflow policy.
+    bool direct = false;  //!< Set by the loader when the reader is executed after the writer in the same activity, the data is handed over without locks and triggers.
 
     /*! \brief Default constructor.
      *  Default values:
@@ -66,6 +84,10 @@ struct ConnectionPolicy
      */
     ConnectionPolicy(const std::string &policy, const std::string &lock,
                      const std::string &transport_type, const std::string &buffer_size);
+    /*! \brief Set \ref overflow parsing it from string.
+     *  \param overflow_policy One of FAIL, DROP_NEWEST, DROP_OLDEST, BLOCK.
+     */
+    void setOverflowPolicy(const std::string &overflow_policy);
 };
 
 #undef NO_DATA
@@ -78,8 +100,184 @@ enum FlowStatus
     NEW_DATA   //!< New data in the buffer.
 };
 
+/*! \brief Snapshot of the counters of a connection, or of all the connections of a port.
+ *  Used to find the bottlenecks of the application graph.
+ */
+struct ConnectionStatistics
+{
+    uint64_t written = 0;        //!< Number of data written in the connection.
+    uint64_t read = 0;           //!< Number of data read from the connection.
+    uint64_t bytes = 0;          //!< Bytes written, sizeof(T) for each data.
+    uint64_t dropped = 0;        //!< Number of data discarded because the buffer was full.
+    uint64_t blocked_time = 0;   //!< Time in us writers have been blocked waiting for room.
+    unsigned int queue_length = 0;  //!< Number of data currently in the buffer.
+    unsigned int high_water = 0;    //!< Maximum number of data queued at the same time.
+    int long last_write = 0;     //!< Time of the last write, see util::monotonicTime(). 0 if never written.
+};
+
+/*! \brief Identifies the item dispatched by a farm source from which a sample derives.
+ *  The tag is propagated through the tasks of the farm workers, so that the gather can
+ *  restore the dispatch order and discard the items that took too long.
+ */
+struct FarmTag
+{
+    uint64_t sequence = 0;   //!< Dispatch order starting from 1, 0 if the sample does not derive from a farm item.
+    int long timestamp = 0;  //!< Time the item was dispatched, see util::monotonicTime().
+};
+
+/*! \brief Header stored together with every sample written in a connection.
+ *  Allows the reader to compute the latency of each edge and to detect lost samples.
+ */
+struct SampleInfo
+{
+    int long timestamp = 0;  //!< Time the sample was written, see util::monotonicTime().
+    uint64_t sequence = 0;   //!< Per connection sequence number starting from 1. Gaps are samples lost in the connection.
+    FarmTag farm;            //!< Farm item the sample derives from, the one last read by the writer task.
+};
+
+/*! \brief Specify how the source of a farm dispatches the items to the workers
+ *  and how the gather receives the results.
+ */
+struct FarmPolicy
+{
+    /*! \brief How the source chooses the worker for an item. Only workers with room in their queue are chosen,
+     *  if all the queues are full the item is discarded and the write fails.
+     */
+    enum Dispatch
+    {
+        IDLE_FIRST,                 //!< An idle worker with an empty queue, otherwise the first with room in Round Robin order.
+        JOIN_SHORTEST_QUEUE,        //!< The worker with the fewest items queued or in execution.
+        POWER_OF_TWO,               //!< The least loaded of two workers chosen at random.
+        LEAST_EXPECTED_COMPLETION,  //!< The worker that would complete the item first given its mean execution time per item.
+                                    //!< The time is measured only with profiling enabled, otherwise as \ref JOIN_SHORTEST_QUEUE.
+        KEY_AFFINITY,               //!< The worker owning the key of the item by consistent hashing, see FarmKey.
+                                    //!< Another worker if the owner has no room or is loaded above \ref key_imbalance.
+        WORK_QUEUE                  //!< The workers share a ConnectionPolicy::WORK_QUEUE of \ref worker_queue items per worker,
+                                    //!< the first free worker takes the next item. Not elastic and without speculation.
+    };
+
+    Dispatch dispatch = IDLE_FIRST;
+    unsigned int worker_queue = 1;  //!< Number of items that can be queued for each worker.
+    double key_imbalance = 0.25;    //!< With KEY_AFFINITY a worker takes an item only if its load is within (1 + key_imbalance) times the mean.
+    bool ordered = true;            //!< Results are released in the order the source dispatched the items.
+    int discard_old_data = 0;       //!< Results older than this time in ms since the dispatch are discarded, 0 to keep all of them.
+    unsigned int reorder_size = 0;  //!< Maximum number of results waiting for an older one, 0 for twice the number of workers.
+    int reorder_timeout = 100;      //!< Time in ms since its dispatch after which a result stops waiting for an older one, 0 to wait until the buffer is full.
+    /* Elastic farm: the source dispatches only to the first workers, the others are parked.
+     * Every scale_interval ms a worker is activated if items were rejected or queued,
+     * or the last one is parked if the others can take its load.
+     */
+    unsigned int workers = 0;       //!< Workers active at start, 0 for all of them.
+    unsigned int min_workers = 0;   //!< Minimum number of active workers.
+    unsigned int max_workers = 0;   //!< Maximum number of active workers, if not greater than min_workers the farm is not elastic.
+    int scale_interval = 100;       //!< Time in ms between two scaling decisions.
+    /* Speculation: an item without a result after speculation times the median completion time
+     * is dispatched again to an idle worker, the gather keeps the first result. See FarmTracker.
+     */
+    double speculation = 0;         //!< Multiple of the median completion time after which an item is late, 0 to disable.
+
+    /*! \brief Set \ref dispatch parsing it from string.
+     *  \param dispatch_policy One of IDLE_FIRST, JOIN_SHORTEST_QUEUE, POWER_OF_TWO, LEAST_EXPECTED_COMPLETION,
+     *  KEY_AFFINITY, WORK_QUEUE.
+     */
+    void setDispatch(const std::string &dispatch_policy);
+};
+
+/*! \brief Statistics of the workers of a farm, kept by the source.
+ */
+struct FarmStatistics
+{
+    unsigned int workers = 0;      //!< Number of workers the source dispatches to.
+    unsigned int min_workers = 0;  //!< Minimum number of active workers.
+    unsigned int max_workers = 0;  //!< Number of instantiated workers.
+    uint64_t rejected = 0;         //!< Items not dispatched because all the queues were full.
+    uint64_t key_spilled = 0;      //!< Items dispatched to a worker not owning their key, only with KEY_AFFINITY.
+    uint64_t scale_up = 0;         //!< Number of times a parked worker has been activated.
+    uint64_t scale_down = 0;       //!< Number of times a worker has been parked.
+    int long last_scale = 0;       //!< Time of the last scaling, see util::monotonicTime(). 0 if never scaled.
+    uint64_t dispatched = 0;       //!< Items dispatched, without the speculative copies.
+    uint64_t speculated = 0;       //!< Items dispatched again because late.
+    uint64_t duplicates = 0;       //!< Results discarded by the gather because of the same item of an earlier one.
+    int long latency_p50 = 0;      //!< Median time in us from dispatch to result of the recent items, only with speculation.
+    int long latency_p99 = 0;      //!< 99th percentile of the same times.
+};
+
+/*! \brief Shared by the source and the gather of a farm with speculation enabled.
+ *  The gather records the results it receives, so that the source knows which items are
+ *  still in the workers and how long an item takes to complete. The gather is the only writer.
+ */
+class FarmTracker
+{
+public:
+    FarmTracker();
+    /*! \brief Record the result of an item.
+     *  \param sequence The sequence of the item, see FarmTag.
+     *  \param latency Time in us from the dispatch of the item to its result.
+     *  \return False if a result of the same item has already been received.
+     */
+    bool complete(uint64_t sequence, int long latency);
+    /*!
+     * \return Whether a result of the item has been received. Only the recent items are remembered,
+     * the source must not keep track of more than \ref WINDOW items.
+     */
+    bool completed(uint64_t sequence) const;
+    /*!
+     * \param percentile Between 0 and 1.
+     * \return The percentile of the time in us from dispatch to result of the last \ref LATENCIES results,
+     * 0 if no result has been received.
+     */
+    int long latency(double percentile) const;
+    /*!
+     * \return The number of results received, without the duplicates.
+     */
+    uint64_t results() const { return results_.load(std::memory_order_relaxed); }
+    /*!
+     * \return The number of duplicate results.
+     */
+    uint64_t duplicates() const { return duplicates_.load(std::memory_order_relaxed); }
+
+    static const unsigned int WINDOW = 4096;
+    static const unsigned int LATENCIES = 256;
+private:
+    std::vector<std::atomic<uint64_t> > completed_;  // Sequence of the last item completed in each slot
+    std::vector<std::atomic<int long> > latencies_;
+    std::atomic<uint64_t> results_ = {0};
+    std::atomic<uint64_t> duplicates_ = {0};
+};
+
 class PortBase;
 
+/*! \brief Delayed trigger of the gather of an ordered farm. While the gather waits for a missing result
+ *  it holds no trigger, the alarm wakes it up when the oldest buffered result stops waiting, see
+ *  FarmPolicy::reorder_timeout and FarmPolicy::discard_old_data.
+ *  One thread serves the alarms of all the farms of the process, it is started by the first alarm.
+ */
+class FarmAlarm : public std::enable_shared_from_this<FarmAlarm>
+{
+public:
+    explicit FarmAlarm(const std::shared_ptr<PortBase> &port);
+    /*! \brief Trigger the port at time, replacing the pending request.
+     *  \param time Absolute time, see util::monotonicTime().
+     */
+    void arm(int long time);
+    /*! \brief Cancel the pending request.
+     */
+    void disarm() { time_.store(0); }
+    /*!
+     * \return The number of triggers added to the port since the last call, the owner of the port counts them as its own.
+     */
+    unsigned int takeFired() { return fired_.exchange(0); }
+private:
+    friend struct FarmAlarmQueue;
+    /*! \brief Called by the alarm thread, the request is served only if it has not been replaced.
+     */
+    void fire(int long time);
+
+    std::weak_ptr<PortBase> port_;
+    std::atomic<int long> time_ = {0};  // Time of the pending request, 0 if none
+    std::atomic<unsigned int> fired_ = {0};
+};
+
 /*! \brief Base class for connections.
  *  Contains the basic funcitons to manage a connection.
  */
@@ -87,8 +285,8 @@ class ConnectionBase
 {
 public:
     /*! Costructor of the connection.
-     *  \param in Input port of the connection.
-     *  \param out Output port of the connection.
+     *  \param in Input port of the connection. Null if the port lives in another process.
+     *  \param out Output port of the connection. Null if the port lives in another process.
      *  \param policy of the connection.
      */
     ConnectionBase(std::shared_ptr<PortBase> in,
@@ -113,28 +311,91 @@ public:
      * \return Pointer to the output port.
      */
     const std::shared_ptr<PortBase> & output() const { return output_; }
+    /*!
+     * \return The policy of the connection.
+     */
+    const ConnectionPolicy & policy() const { return policy_; }
     /*!
      * \return The lenght of the queue in the connection
      */
      virtual unsigned int queueLength() const = 0;
+    /*!
+     * \return The number of data discarded because the buffer was full.
+     */
+    uint64_t droppedCount() const { return dropped_; }
+    /*!
+     * \return The total time in microseconds writers have been blocked waiting for room in the buffer.
+     */
+    uint64_t blockedTime() const { return blocked_time_; }
+    /*!
+     * \return The maximum number of data that has been present in the buffer at the same time.
+     */
+    unsigned int highWaterMark() const { return high_water_; }
+    /*!
+     * \return A snapshot of the counters of the connection.
+     */
+    ConnectionStatistics statistics() const;
+    /*! \brief Account for \p count data read from the connection. Called by the input connection managers.
+     */
+    void addRead(unsigned int count = 1) { read_.fetch_add(count, std::memory_order_relaxed); }
+    /*! \brief Set the farm item from which the data written next by the output task derives.
+     *  Called by the farm source before dispatching an item.
+     */
+    void setFarmTag(const FarmTag &tag);
 protected:
     /*! \brief Call InputPort::triggerComponent() function to trigger the owner component execution.
+     *  \param count Number of triggers, one for each data added.
      */
-    void trigger();
+    void trigger(unsigned int count = 1);
     /*! \brief Once data has been read remove the trigger calling InputPort::removeTriggerComponent()
+     *  \param count Number of triggers, one for each data read.
+     *  \return The number of triggers actually removed, less than count if the component had fewer.
     */
-    void removeTrigger();
+    unsigned int removeTrigger(unsigned int count = 1);
+    /*! \brief Wake up the threads waiting for data on the input port with InputPort::read(T &, timeout)
+     *  and account for the written data. Must be called every time data is added to the connection.
+     *  \param count The number of data written, 0 if written by another process.
+     */
+    void notify(unsigned int count = 1);
+    /*! \brief Create the header of the samples being written.
+     *  \param count Number of samples written together, they take consecutive sequence numbers
+     *  starting from the one returned.
+     */
+    SampleInfo stamp(unsigned int count = 1);
+    /*! \brief Propagate the latency timestamp from the task of the output port to the one of the input port.
+     *  \param info The header of the data read, its farm tag is propagated to the task of the input port.
+     */
+    void propagateLatency(const SampleInfo *info = nullptr);
+    /*! \brief Account for \p count data discarded because the buffer was full.
+     */
+    void addDropped(unsigned int count = 1) { dropped_.fetch_add(count, std::memory_order_relaxed); }
+    /*! \brief Account for \p time microseconds spent by a writer waiting for room.
+     */
+    void addBlockedTime(uint64_t time) { blocked_time_.fetch_add(time, std::memory_order_relaxed); }
+    /*! \brief Update the high-water mark with the current queue \p length.
+     */
+    void updateHighWater(unsigned int length);
 
     std::shared_ptr<PortBase> input_;
     std::shared_ptr<PortBase> output_;
 
     FlowStatus data_status_;
     ConnectionPolicy policy_;
+
+    size_t sample_size_ = 0;  //!< Size of the type transported, used to count the written bytes.
+
+    std::atomic<uint64_t> written_ = {0};
+    std::atomic<uint64_t> read_ = {0};
+    std::atomic<uint64_t> dropped_ = {0};
+    std::atomic<uint64_t> blocked_time_ = {0};
+    std::atomic<unsigned int> high_water_ = {0};
+    std::atomic<int long> last_write_ = {0};
+    std::atomic<uint64_t> sequence_ = {0};
 };
 
 /*!\brief Used to specify to the port factory which connection manager to instantiate.
  */
-enum class ConnectionManagerType {DEFAULT = 0, FARM};
+enum class ConnectionManagerType {DEFAULT = 0, FARM, FAN_IN};
 /*! Manages the connections of one PortBase
  *  Ports can have multiple connections associated to them.
  *  ConnectionManager keeps track of all these connections.
@@ -144,6 +405,7 @@ enum class ConnectionManagerType {DEFAULT = 0, FARM};
 class ConnectionManager
 {
 public:
+    virtual ~ConnectionManager() {}
     /*!
      * \param connection Shared pointer of the connection to be added at the \ref owner_ port.
      */
@@ -159,17 +421,61 @@ public:
      * in all the connection if not specified
      */
     int queueLenght(int connection = -1) const;
+    /*!
+     * \param connection The connection id, if -1 the counters of all the connections are aggregated:
+     * summed, except the high-water mark and the last write time that are the maximum.
+     * \return The statistics of the connection.
+     */
+    ConnectionStatistics statistics(int connection = -1) const;
     /*!
      * \return Number of connections.
      */
     int connectionsCount() const;
+    /*!
+     * \param connection The connection id, if -1 the sum over all the connections.
+     * \return The number of data discarded because the buffer was full.
+     */
+    uint64_t droppedCount(int connection = -1) const;
+    /*!
+     * \param connection The connection id, if -1 the sum over all the connections.
+     * \return The time in microseconds writers have been blocked on full buffers.
+     */
+    uint64_t blockedTime(int connection = -1) const;
+    /*!
+     * \param connection The connection id, if -1 the maximum among all the connections.
+     * \return The high-water mark of the queue.
+     */
+    unsigned int highWaterMark(int connection = -1) const;
+    /*! \brief Set how the items are dispatched to the farm workers and how the results are received.
+     *  Only used by the source and the gather of a farm.
+     */
+    virtual void setFarmPolicy(const FarmPolicy &policy) { farm_policy_ = policy; }
+    /*! \brief Set the tracker shared by the source and the gather of a farm with speculation.
+     */
+    void setFarmTracker(std::shared_ptr<FarmTracker> tracker) { farm_tracker_ = tracker; }
+    /*!
+     * \return The number of farm results received before an older one. Only for the gather of a farm.
+     */
+    virtual uint64_t reorderedCount() const { return 0; }
+    /*!
+     * \return The number of farm results discarded because too old or arrived after a newer one
+     *  had already been released. Only for the gather of a farm.
+     */
+    virtual uint64_t discardedCount() const { return 0; }
+    /*!
+     * \return The statistics of the workers of the farm. Only for the source of a farm.
+     */
+    virtual FarmStatistics farmStatistics() const { return FarmStatistics(); }
 
 private:
     friend class GraphLoader;
+    friend class ComponentRegistry;
     const std::vector<std::shared_ptr<ConnectionBase>> & connections() const { return connections_; }
 
 protected:
     std::vector<std::shared_ptr<ConnectionBase> > connections_;  //!< List of ConnectionBase associate to \ref owner_
+    FarmPolicy farm_policy_;
+    std::shared_ptr<FarmTracker> farm_tracker_;
 };
 
 
@@ -9,15 +9,26 @@
  */
 
 #pragma once
+#include <algorithm>
 #include <memory>
 #include <string>
 #include <vector>
 #include <iomanip>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <random>
+#include <thread>
+#include <type_traits>
 
 #include <boost/circular_buffer.hpp>
 #include <boost/lockfree/spsc_queue.hpp>
 
 #include "coco/connection.h"
+#include "coco/util/ipc.h"
+#include "coco/util/mpmc_queue.hpp"
+#include "coco/util/mpsc_queue.hpp"
 
 #include "coco/task_impl.hpp"
 #include "execution.h"
@@ -32,14 +43,17 @@ class ConnectionT : public ConnectionBase
 {
 public:
     /*! \brief Simply call ConnectionBase constructor with the templated ports.
+     *  One of the two ports can be null if it lives in another process.
      */
     ConnectionT(std::shared_ptr<InputPort<T> > in,
                 std::shared_ptr<OutputPort<T> > out,
                 ConnectionPolicy policy)
-        : ConnectionBase(in->sharedPtr(),
-                         out->sharedPtr(),
+        : ConnectionBase(in ? in->sharedPtr() : nullptr,
+                         out ? out->sharedPtr() : nullptr,
                          policy)
-    {}
+    {
+        this->sample_size_ = sizeof(T);
+    }
 
     using ConnectionBase::ConnectionBase;
     /*! \brief Retreive data from the connection if present.
@@ -47,11 +61,197 @@ public:
      *  \return If new data was present or not.
      */
     virtual FlowStatus data(T &data) = 0;
+    /*! \brief Same as \ref data(T &) but also retreive the header of the sample.
+     *  \param data The variable where to store the data.
+     *  \param info The variable where to store the timestamp and sequence number of the data.
+     *  \return If new data was present or not.
+     */
+    virtual FlowStatus data(T &data, SampleInfo &info) = 0;
     /*! \brief Add data to the connection. If the input port is of type event start the trigger process.
      *  \param data The data to be written in the connection.
      *  \return Wheter the write succeded. It may fail if the buffer is full.
      */
     virtual bool addData(const T &data) = 0;
+    /*! \brief Same as \ref addData(const T &) but the connection takes the ownership of \p data.
+     *  The default implementation copies it.
+     *  \param data The data to be moved in the connection.
+     *  \return Wheter the write succeded. It may fail if the buffer is full.
+     */
+    virtual bool addData(T &&data)
+    {
+        return addData(static_cast<const T &>(data));
+    }
+    /*!
+     * \return Wheter the data added to the connection is stored in it. Connections sharing the storage
+     *  with other connections of the same output port may discard it, so it must not be moved in them.
+     */
+    virtual bool storesData() const
+    {
+        return true;
+    }
+    /*! \brief Retreive a read-only reference to the data, if present, without copying it
+     *  when it was added as a shared sample, see \ref addSample().
+     *  The default implementation copies the data in a new sample.
+     *  \param data The shared pointer where to store the sample.
+     *  \return If new data was present or not.
+     */
+    virtual FlowStatus sample(std::shared_ptr<const T> &data)
+    {
+        T value;
+        if (this->data(value) != NEW_DATA)
+            return NO_DATA;
+        data = std::make_shared<const T>(value);
+        return NEW_DATA;
+    }
+    /*! \brief Add a sample to the connection sharing it with the other connections of the port.
+     *  The default implementation copies the content of the sample.
+     *  \param data The sample to be written in the connection.
+     *  \return Wheter the write succeded. It may fail if the buffer is full.
+     */
+    virtual bool addSample(const std::shared_ptr<const T> &data)
+    {
+        return addData(*data);
+    }
+    /*! \brief Retreive up to \p n data from the connection with a single access.
+     *  The default implementation calls \ref data() for each element.
+     *  \param data Array of at least \p n elements where to store the data.
+     *  \param n Maximum number of data to read.
+     *  \return The number of data read.
+     */
+    virtual unsigned int dataN(T *data, unsigned int n)
+    {
+        unsigned int count = 0;
+        while (count < n && this->data(data[count]) == NEW_DATA)
+            ++count;
+        return count;
+    }
+    /*! \brief Add \p n data to the connection with a single access, triggering the input port once for each data.
+     *  The default implementation calls \ref addData() for each element.
+     *  \param data Array of \p n elements to be written.
+     *  \param n Number of data to write.
+     *  \return The number of data added. It may be less than \p n if the buffer is full.
+     */
+    virtual unsigned int addDataN(const T *data, unsigned int n)
+    {
+        unsigned int count = 0;
+        for (unsigned int i = 0; i < n; ++i)
+        {
+            if (addData(data[i]))
+                ++count;
+        }
+        return count;
+    }
+protected:
+    /*! \brief Account for \p count data discarded because the buffer is full.
+     *  \return The result of the write, true only with ConnectionPolicy::DROP_NEWEST.
+     */
+    bool overflow(unsigned int count = 1)
+    {
+        this->addDropped(count);
+        return this->policy_.overflow == ConnectionPolicy::DROP_NEWEST;
+    }
+    /*!
+     * \return Wheter a full buffer makes room for new data discarding the oldest one.
+     */
+    bool overwrites() const
+    {
+        return this->policy_.data_policy == ConnectionPolicy::CIRCULAR ||
+               this->policy_.overflow == ConnectionPolicy::DROP_OLDEST;
+    }
+    /*! \brief With ConnectionPolicy::BLOCK retry \p push until it succeeds or
+     *  ConnectionPolicy::overflow_timeout expires. Used by the connections without a mutex to wait on.
+     *  \param push Callable returning wheter the data has been pushed.
+     *  \return Wheter the data has been pushed.
+     */
+    template <class F>
+    bool retryPush(F push)
+    {
+        if (this->policy_.overflow != ConnectionPolicy::BLOCK)
+            return false;
+
+        auto start = std::chrono::steady_clock::now();
+        auto deadline = start + std::chrono::milliseconds(this->policy_.overflow_timeout);
+        bool pushed;
+        while (!(pushed = push()) && std::chrono::steady_clock::now() < deadline)
+            std::this_thread::yield();
+        this->addBlockedTime(std::chrono::duration_cast<std::chrono::microseconds>(
+                                 std::chrono::steady_clock::now() - start).count());
+        return pushed;
+    }
+    /*! \brief Used by the lock free connections, where the writer triggers the component after the data
+     *  is visible, so the reader can read it before the trigger is added. The connection counts the triggers
+     *  and the reader removes, with \ref reconcileTriggers(), the ones exceeding the data present.
+     */
+    void countTriggers(std::atomic<unsigned int> &triggered, unsigned int count = 1)
+    {
+        if (!this->input_->isEvent() || count == 0)
+            return;
+        triggered.fetch_add(count, std::memory_order_acq_rel);
+        this->trigger(count);
+    }
+    /*! \brief Called by the reader after every read, also when no data was found, so that a trigger
+     *  added after its data has been read is removed at the next execution.
+     *  If the trigger has been counted but not yet added the count is restored and it is removed
+     *  at the execution it causes.
+     *  \param present The data still in the connection. An overestimate only delays the removal.
+     */
+    void reconcileTriggers(std::atomic<unsigned int> &triggered, unsigned int present)
+    {
+        if (!this->input_->isEvent())
+            return;
+        unsigned int count = triggered.load(std::memory_order_acquire);
+        while (count > present)
+        {
+            if (triggered.compare_exchange_weak(count, count - 1, std::memory_order_acq_rel))
+            {
+                if (this->removeTrigger() == 0)
+                {
+                    triggered.fetch_add(1, std::memory_order_acq_rel);
+                    break;
+                }
+                --count;
+            }
+        }
+    }
+};
+
+/*! \brief Element stored by the connections. It contains either a copy of the written value
+ *  or a reference to a sample published with OutputPort::publish().
+ */
+template <class T>
+struct SampleSlot
+{
+    SampleSlot() = default;
+    explicit SampleSlot(const T &data) : value(data) {}
+    explicit SampleSlot(T &&data) : value(std::move(data)) {}
+    explicit SampleSlot(const std::shared_ptr<const T> &data) : sample(data) {}
+
+    /* The value is moved out, it is not read again once consumed */
+    static void get(T &value, const std::shared_ptr<const T> &sample, T &data)
+    {
+        if (sample)
+            data = *sample;
+        else
+            data = std::move(value);
+    }
+    static void get(T &value, const std::shared_ptr<const T> &sample,
+                    std::shared_ptr<const T> &data)
+    {
+        data = sample ? sample : std::make_shared<const T>(std::move(value));
+    }
+    template <class D>
+    void get(D &data) { get(value, sample, data); }
+    template <class D>
+    void get(D &data, SampleInfo *data_info)
+    {
+        get(value, sample, data);
+        if (data_info)
+            *data_info = info;
+    }
+
+    T value;
+    std::shared_ptr<const T> sample;
+    SampleInfo info;
 };
 
 /*! \brief Specialized class for the type T to manage
@@ -78,10 +278,71 @@ public:
 
     FlowStatus data(T &data) final
     {
+        return readData(data);
+    }
+
+    FlowStatus data(T &data, SampleInfo &info) final
+    {
+        return readData(data, &info);
+    }
+
+    FlowStatus sample(std::shared_ptr<const T> &data) final
+    {
+        return readData(data);
+    }
+
+    bool addData(const T &input) final
+    {
+        return writeData(input);
+    }
+
+    bool addData(T &&input) final
+    {
+        return writeData(std::move(input));
+    }
+
+    bool addSample(const std::shared_ptr<const T> &input) final
+    {
+        std::unique_lock<std::mutex> mlock(this->mutex_);
+        FlowStatus old_status = this->data_status_;
+        /* value_ is constructed anyway to keep it valid for the following addData */
+        if (this->data_status_ == NO_DATA)
+            new (&value_) T();
+        sample_ = input;
+        info_ = this->stamp();
+        this->data_status_ = NEW_DATA;
+
+        this->notify();
+        if (this->input()->isEvent() &&
+            old_status != NEW_DATA )
+            this->trigger();
+
+        return true;
+    }
+
+    /* Only the newest value is kept */
+    unsigned int addDataN(const T *data, unsigned int n) final
+    {
+        return n > 0 && addData(data[n - 1]) ? n : 0;
+    }
+
+    unsigned int queueLength() const final
+    {
+        return this->data_status_ == NEW_DATA ? 1 : 0;
+    }
+private:
+    template <class D>
+    FlowStatus readData(D &data, SampleInfo *info = nullptr)
+    {
+        SampleInfo local_info;
+        if (!info)
+            info = &local_info;
         std::unique_lock<std::mutex> mlock(this->mutex_);
         if (this->data_status_ == NEW_DATA)
         {
-            data = value_;  // copy => std::move
+            SampleSlot<T>::get(value_, sample_, data);
+            sample_.reset();
+            *info = info_;
             this->data_status_ = OLD_DATA;
             if (destructor_policy_)
             {
@@ -91,29 +352,29 @@ public:
             if (this->input_->isEvent())
                 this->removeTrigger();
 
-            /* Propagate timestamp to calculate latency */
-            int long latency_time = this->output_->task()->latencyTimestamp();
-            if (latency_time > 0)
-                this->input_->task()->setLatencyTimestamp(latency_time);
+            this->propagateLatency(info);
 
             return NEW_DATA;
         }
         return this->data_status_;
     }
 
-    bool addData(const T &input) final
+    template <class D>
+    bool writeData(D &&input)
     {
         std::unique_lock<std::mutex> mlock(this->mutex_);
         FlowStatus old_status = this->data_status_;
+        sample_.reset();
+        info_ = this->stamp();
         if (destructor_policy_)
         {
             if (this->data_status_ == NEW_DATA)
             {
-                value_ = input;
+                value_ = std::forward<D>(input);
             }
             else
             {
-                new (&value_) T(input);
+                new (&value_) T(std::forward<D>(input));
                 this->data_status_ = NEW_DATA;  // mark
             }
         }
@@ -121,15 +382,16 @@ public:
         {
             if (this->data_status_ == NO_DATA)
             {
-                new (&value_) T(input);  // allocate new data in the given space
+                new (&value_) T(std::forward<D>(input));  // allocate new data in the given space
                 this->data_status_ = NEW_DATA;
             }
             else
             {
-                value_ = input;
+                value_ = std::forward<D>(input);
                 this->data_status_ = NEW_DATA;
             }
         }
+        this->notify();
         /* trigger if the input port is an event port */
         if (this->input()->isEvent() &&
             old_status != NEW_DATA )
@@ -138,17 +400,14 @@ public:
         return true;
     }
 
-    unsigned int queueLength() const final
-    {
-        return this->data_status_ == NEW_DATA ? 1 : 0;
-    }
-private:
     // TODO add the possibility to set this option from outside.
     bool destructor_policy_ = false;  // Specify wheter to keep old data, or to deallocate it
     union
     {
         T value_;
     };
+    std::shared_ptr<const T> sample_;  // Published sample, when set it is newer than value_
+    SampleInfo info_;
     std::mutex mutex_;
 };
 
@@ -172,9 +431,67 @@ public:
 
     FlowStatus data(T &data) final
     {
+        return readData(data);
+    }
+
+    FlowStatus data(T &data, SampleInfo &info) final
+    {
+        return readData(data, &info);
+    }
+
+    FlowStatus sample(std::shared_ptr<const T> &data) final
+    {
+        return readData(data);
+    }
+
+    bool addData(const T &input) final
+    {
+        return writeData(input);
+    }
+
+    bool addData(T &&input) final
+    {
+        return writeData(std::move(input));
+    }
+
+    bool addSample(const std::shared_ptr<const T> &input) final
+    {
+        FlowStatus old_status = this->data_status_;
+        /* value_ is constructed anyway to keep it valid for the following addData */
+        if (this->data_status_ == NO_DATA)
+            new (&value_) T();
+        sample_ = input;
+        info_ = this->stamp();
+        this->data_status_ = NEW_DATA;
+
+        this->notify();
+        if (this->input_->isEvent() && old_status != NEW_DATA)
+            this->trigger();
+        return true;
+    }
+
+    /* Only the newest value is kept */
+    unsigned int addDataN(const T *data, unsigned int n) final
+    {
+        return n > 0 && addData(data[n - 1]) ? n : 0;
+    }
+
+    unsigned int queueLength() const final
+    {
+        return this->data_status_ == NEW_DATA ? 1 : 0;
+    }
+private:
+    template <class D>
+    FlowStatus readData(D &data, SampleInfo *info = nullptr)
+    {
+        SampleInfo local_info;
+        if (!info)
+            info = &local_info;
         if (this->data_status_ == NEW_DATA)
         {
-            data = value_;  // copy => std::move
+            SampleSlot<T>::get(value_, sample_, data);
+            sample_.reset();
+            *info = info_;
             this->data_status_ = OLD_DATA;
             if (destructor_policy_)
             {
@@ -184,28 +501,28 @@ public:
             if (this->input_->isEvent())
                 this->removeTrigger();
 
-            /* Propagate timestamp to calculate latency */
-            int long latency_time = this->output_->task()->latencyTimestamp();
-            if (latency_time > 0)
-                this->input_->task()->setLatencyTimestamp(latency_time);
+            this->propagateLatency(info);
 
             return NEW_DATA;
         }
         return this->data_status_;
     }
 
-    bool addData(const T &input) final
+    template <class D>
+    bool writeData(D &&input)
     {
         FlowStatus old_status = this->data_status_;
+        sample_.reset();
+        info_ = this->stamp();
         if (destructor_policy_)
         {
             if (this->data_status_ == NEW_DATA)
             {
-                value_ = input;
+                value_ = std::forward<D>(input);
             }
             else
             {
-                new (&value_) T(input);
+                new (&value_) T(std::forward<D>(input));
                 this->data_status_ = NEW_DATA;  // mark
             }
         }
@@ -213,33 +530,37 @@ public:
         {
             if (this->data_status_ == NO_DATA)
             {
-                new (&value_) T(input);  // allocate new data in the given space
+                new (&value_) T(std::forward<D>(input));  // allocate new data in the given space
                 this->data_status_ = NEW_DATA;
             }
             else
             {
-                value_ = input;
+                value_ = std::forward<D>(input);
                 this->data_status_ = NEW_DATA;
             }
         }
+        this->notify();
         /* trigger if the input port is an event port */
         if (this->input_->isEvent() && old_status != NEW_DATA)
             this->trigger();
         return true;
     }
 
-    unsigned int queueLength() const final
-    {
-        return this->data_status_ == NEW_DATA ? 1 : 0;
-    }
-private:
     bool destructor_policy_ = false;
     union
     {
         T value_;
     };
+    std::shared_ptr<const T> sample_;  // Published sample, when set it is newer than value_
+    SampleInfo info_;
 };
 
+/*! \brief Specialized class for the type T to manage ConnectionPolicy::DATA ConnectionPolicy::LOCK_FREE
+ *  Implemented as a triple buffer: the writer fills the back buffer and swaps it with the middle one,
+ *  the reader swaps the front buffer with the middle one when it contains new data.
+ *  Both sides need a single atomic exchange, so they are wait-free, and incoming data always
+ *  overrides the one not yet read.
+ */
 template <class T>
 class ConnectionDataLF : public ConnectionT<T>
 {
@@ -251,39 +572,97 @@ public:
     {}
 
 
-    FlowStatus data(T & data) final
+    FlowStatus data(T &data) final
     {
-        bool new_data = queue_.pop(data);
-        if (new_data)
-        {
-            /* Propagate timestamp to calculate latency */
-            int long latency_time = this->output_->task()->latencyTimestamp();
-            if (latency_time > 0)
-                this->input_->task()->setLatencyTimestamp(latency_time);
+        return readData(data);
+    }
 
-            return NEW_DATA;
-        }
-        return NO_DATA;
+    FlowStatus data(T &data, SampleInfo &info) final
+    {
+        return readData(data, &info);
+    }
+
+    FlowStatus sample(std::shared_ptr<const T> &data) final
+    {
+        return readData(data);
     }
 
     bool addData(const T &input) final
     {
-        if (!queue_.push(input))
-        {
-            return false;
-        }
-        if (this->input_->isEvent())
-            this->trigger();
+        buffers_[back_].value = input;
+        buffers_[back_].sample.reset();
+        return swapBack();
+    }
 
-        return true;
+    bool addData(T &&input) final
+    {
+        buffers_[back_].value = std::move(input);
+        buffers_[back_].sample.reset();
+        return swapBack();
+    }
+
+    bool addSample(const std::shared_ptr<const T> &input) final
+    {
+        buffers_[back_].sample = input;
+        return swapBack();
+    }
+
+    /* Only the newest value is kept */
+    unsigned int addDataN(const T *data, unsigned int n) final
+    {
+        return n > 0 && addData(data[n - 1]) ? n : 0;
     }
 
     unsigned int queueLength() const final
     {
-        return this->data_status_ == NEW_DATA ? 1 : 0;
+        return (middle_.load(std::memory_order_relaxed) & NEW_DATA_FLAG) ? 1 : 0;
     }
 private:
-    boost::lockfree::spsc_queue<T, boost::lockfree::capacity<1> > queue_;
+    enum : unsigned int { INDEX_MASK = 0x3, NEW_DATA_FLAG = 0x4 };
+
+    template <class D>
+    FlowStatus readData(D &data, SampleInfo *info = nullptr)
+    {
+        SampleInfo local_info;
+        if (!info)
+            info = &local_info;
+        /* Only the writer can set the flag, so it is still set at the exchange */
+        if (!(middle_.load(std::memory_order_relaxed) & NEW_DATA_FLAG))
+        {
+            this->reconcileTriggers(triggered_, queueLength());
+            return read_once_ ? OLD_DATA : NO_DATA;
+        }
+
+        front_ = middle_.exchange(front_, std::memory_order_acq_rel) & INDEX_MASK;
+        buffers_[front_].get(data, info);
+        buffers_[front_].sample.reset();
+        read_once_ = true;
+        this->reconcileTriggers(triggered_, queueLength());
+
+        this->propagateLatency(info);
+
+        return NEW_DATA;
+    }
+
+    bool swapBack()
+    {
+        buffers_[back_].info = this->stamp();
+        unsigned int old = middle_.exchange(back_ | NEW_DATA_FLAG, std::memory_order_acq_rel);
+        back_ = old & INDEX_MASK;
+        this->notify();
+        /* Data not yet read has been overridden, the component has already been triggered */
+        if (!(old & NEW_DATA_FLAG))
+            this->countTriggers(triggered_);
+
+        return true;
+    }
+
+    SampleSlot<T> buffers_[3];
+    unsigned int back_ = 0;  // Owned by the writer
+    unsigned int front_ = 1;  // Owned by the reader
+    bool read_once_ = false;  // Owned by the reader
+    std::atomic<unsigned int> middle_ = {2};  // Index of the middle buffer and NEW_DATA_FLAG
+    std::atomic<unsigned int> triggered_ = {0};  // Triggers added and not yet removed
 };
 
 /*! \brief Specialized class for the type T to manage ConnectionPolicy::BUFFER/CIRCULAR_BUFFER ConnectionPolicy::LOCKED
@@ -306,70 +685,183 @@ public:
     {
         std::unique_lock<std::mutex> mlock(this->mutex_);
         bool status = false;
+        SampleInfo info;
         while (!buffer_.empty())
         {
-            data = buffer_.front();
+            buffer_.front().get(data, &info);
             buffer_.pop_front();
             status = true;
         }
         if (status)
         {
+            notifySpace();
             if (this->input_->isEvent())
                 this->removeTrigger();
 
-            /* Propagate timestamp to calculate latency */
-            int long latency_time = this->output_->task()->latencyTimestamp();
-            if (latency_time > 0)
-                this->input_->task()->setLatencyTimestamp(latency_time);
+            this->propagateLatency(&info);
         }
         return status ? NEW_DATA : NO_DATA;
     }
 
     FlowStatus data(T &data) final
     {
+        return readData(data);
+    }
+
+    FlowStatus data(T &data, SampleInfo &info) final
+    {
+        return readData(data, &info);
+    }
+
+    FlowStatus sample(std::shared_ptr<const T> &data) final
+    {
+        return readData(data);
+    }
+
+    bool addData(const T &input) final
+    {
+        return addSlot(SampleSlot<T>(input));
+    }
+
+    bool addData(T &&input) final
+    {
+        return addSlot(SampleSlot<T>(std::move(input)));
+    }
+
+    bool addSample(const std::shared_ptr<const T> &input) final
+    {
+        return addSlot(SampleSlot<T>(input));
+    }
+
+    unsigned int dataN(T *data, unsigned int n) final
+    {
+        std::unique_lock<std::mutex> mlock(this->mutex_);
+        unsigned int count = 0;
+        SampleInfo info;
+        while (count < n && !buffer_.empty())
+        {
+            buffer_.front().get(data[count++], &info);
+            buffer_.pop_front();
+        }
+        if (count > 0)
+        {
+            notifySpace();
+            if (this->input_->isEvent())
+                this->removeTrigger(count);
+
+            this->propagateLatency(&info);
+        }
+        return count;
+    }
+
+    unsigned int addDataN(const T *data, unsigned int n) final
+    {
+        std::unique_lock<std::mutex> mlock(this->mutex_);
+        SampleInfo info = this->stamp(n);
+        unsigned int count = 0;
+        unsigned int triggers = 0;  // Overwritten data has already triggered the component
+        for (; count < n; ++count)
+        {
+            bool overwritten = buffer_.full() && this->overwrites();
+            if (buffer_.full() && !makeRoom(mlock))
+            {
+                this->overflow(n - count);
+                break;
+            }
+            buffer_.push_back(SampleSlot<T>(data[count]));
+            buffer_.back().info = info;
+            ++info.sequence;
+            if (!overwritten)
+                ++triggers;
+        }
+        this->updateHighWater(buffer_.size());
+        if (count > 0)
+        {
+            this->notify(count);
+            if (this->input_->isEvent())
+                this->trigger(triggers);
+        }
+
+        return count;
+    }
+
+    unsigned int queueLength() const final
+    {
+        return buffer_.size();
+    }
+private:
+    template <class D>
+    FlowStatus readData(D &data, SampleInfo *info = nullptr)
+    {
+        SampleInfo local_info;
+        if (!info)
+            info = &local_info;
         std::unique_lock<std::mutex> mlock(this->mutex_);
         if (!buffer_.empty())
         {
-            data = buffer_.front();
+            buffer_.front().get(data, info);
             buffer_.pop_front();
+            notifySpace();
             if (this->input_->isEvent())
                 this->removeTrigger();
 
-            /* Propagate timestamp to calculate latency */
-            int long latency_time = this->output_->task()->latencyTimestamp();
-            if (latency_time > 0)
-                this->input_->task()->setLatencyTimestamp(latency_time);
+            this->propagateLatency(info);
 
             return NEW_DATA;
         }
         return NO_DATA;
     }
 
-    bool addData(const T &input) final
+    bool addSlot(SampleSlot<T> &&slot)
     {
         std::unique_lock<std::mutex> mlock(this->mutex_);
 
-        if (buffer_.full())
-        {
-            if (this->policy_.data_policy == ConnectionPolicy::CIRCULAR)
-                buffer_.pop_front();
-            else
-                return false;
-        }
-        buffer_.push_back(input);
+        slot.info = this->stamp();
+        bool overwritten = buffer_.full() && this->overwrites();
+        if (buffer_.full() && !makeRoom(mlock))
+            return this->overflow();
+        buffer_.push_back(std::move(slot));
+        this->updateHighWater(buffer_.size());
 
-        if (this->input_->isEvent() && !buffer_.full())
+        this->notify();
+        /* Data not yet read has been overwritten, the component has already been triggered */
+        if (this->input_->isEvent() && !overwritten)
             this->trigger();
 
         return true;
     }
-    unsigned int queueLength() const final
+
+    /*! \brief Called with the buffer full, apply the overflow policy.
+     *  \return Wheter there is room for new data.
+     */
+    bool makeRoom(std::unique_lock<std::mutex> &mlock)
     {
-        return buffer_.size();
+        if (this->overwrites())
+        {
+            buffer_.pop_front();
+            this->addDropped();
+            return true;
+        }
+        if (this->policy_.overflow != ConnectionPolicy::BLOCK)
+            return false;
+
+        auto start = std::chrono::steady_clock::now();
+        bool room = space_cond_.wait_for(mlock, std::chrono::milliseconds(this->policy_.overflow_timeout),
+                                         [this] () { return !buffer_.full(); });
+        this->addBlockedTime(std::chrono::duration_cast<std::chrono::microseconds>(
+                                 std::chrono::steady_clock::now() - start).count());
+        return room;
     }
-private:
-    boost::circular_buffer<T> buffer_;
+    /* Wake up the writer blocked on a full buffer */
+    void notifySpace()
+    {
+        if (this->policy_.overflow == ConnectionPolicy::BLOCK)
+            space_cond_.notify_one();
+    }
+
+    boost::circular_buffer<SampleSlot<T> > buffer_;
     std::mutex mutex_;
+    std::condition_variable space_cond_;
 };
 
 /*! \brief Specialized class for the type T to manage ConnectionPolicy::BUFFER/CIRCULAR_BUFFER ConnectionPolicy::UNSYNC
@@ -383,7 +875,7 @@ public:
                       ConnectionPolicy policy)
         : ConnectionT<T>(in, out, policy)
     {
-        buffer_.resize(policy.buffer_size);
+        buffer_.set_capacity(policy.buffer_size);
     }
     /*! \brief Remove all data in the buffer and return the last value
      *  \param data The variable where to store data
@@ -391,10 +883,11 @@ public:
     FlowStatus newestData(T &data)
     {
         bool status = false;
+        SampleInfo info;
         while (!buffer_.empty())
         {
             status = true;
-            data = buffer_.front();
+            buffer_.front().get(data, &info);
             buffer_.pop_front();
         }
         if (status)
@@ -402,27 +895,110 @@ public:
             if (this->input_->isEvent())
                 this->removeTrigger();
 
-            /* Propagate timestamp to calculate latency */
-            int long latency_time = this->output_->task()->latencyTimestamp();
-            if (latency_time > 0)
-                this->input_->task()->setLatencyTimestamp(latency_time);
+            this->propagateLatency(&info);
         }
         return status ? NEW_DATA : NO_DATA;
     }
 
-    FlowStatus data(T & data) final
+    FlowStatus data(T &data) final
+    {
+        return readData(data);
+    }
+
+    FlowStatus data(T &data, SampleInfo &info) final
+    {
+        return readData(data, &info);
+    }
+
+    FlowStatus sample(std::shared_ptr<const T> &data) final
+    {
+        return readData(data);
+    }
+
+    bool addData(const T &input) final
+    {
+        return addSlot(SampleSlot<T>(input));
+    }
+
+    bool addData(T &&input) final
+    {
+        return addSlot(SampleSlot<T>(std::move(input)));
+    }
+
+    bool addSample(const std::shared_ptr<const T> &input) final
+    {
+        return addSlot(SampleSlot<T>(input));
+    }
+
+    unsigned int dataN(T *data, unsigned int n) final
+    {
+        unsigned int count = 0;
+        SampleInfo info;
+        while (count < n && !buffer_.empty())
+        {
+            buffer_.front().get(data[count++], &info);
+            buffer_.pop_front();
+        }
+        if (count > 0)
+        {
+            if (this->input_->isEvent())
+                this->removeTrigger(count);
+
+            this->propagateLatency(&info);
+        }
+        return count;
+    }
+
+    unsigned int addDataN(const T *data, unsigned int n) final
+    {
+        SampleInfo info = this->stamp(n);
+        unsigned int count = 0;
+        unsigned int triggers = 0;  // Overwritten data has already triggered the component
+        for (; count < n; ++count)
+        {
+            bool overwritten = buffer_.full() && this->overwrites();
+            if (buffer_.full() && !makeRoom())
+            {
+                this->overflow(n - count);
+                break;
+            }
+            buffer_.push_back(SampleSlot<T>(data[count]));
+            buffer_.back().info = info;
+            ++info.sequence;
+            if (!overwritten)
+                ++triggers;
+        }
+        this->updateHighWater(buffer_.size());
+        if (count > 0)
+        {
+            this->data_status_ = NEW_DATA;
+            this->notify(count);
+            if (this->input_->isEvent())
+                this->trigger(triggers);
+        }
+
+        return count;
+    }
+
+    unsigned int queueLength() const final
+    {
+        return buffer_.size();
+    }
+private:
+    template <class D>
+    FlowStatus readData(D &data, SampleInfo *info = nullptr)
     {
+        SampleInfo local_info;
+        if (!info)
+            info = &local_info;
         if (!buffer_.empty())
         {
-            data = buffer_.front();
+            buffer_.front().get(data, info);
             buffer_.pop_front();
             if (this->input_->isEvent())
                 this->removeTrigger();
 
-            /* Propagate timestamp to calculate latency */
-            int long latency_time = this->output_->task()->latencyTimestamp();
-            if (latency_time > 0)
-                this->input_->task()->setLatencyTimestamp(latency_time);
+            this->propagateLatency(info);
 
             return NEW_DATA;
         }
@@ -430,33 +1006,42 @@ public:
             return NO_DATA;
     }
 
-    bool addData(const T &input) final
+    bool addSlot(SampleSlot<T> &&slot)
     {
-        if (buffer_.full())
-        {
-            if (this->policy_.data_policy == ConnectionPolicy::CIRCULAR)
-                buffer_.pop_front();
-            else
-                return false;
-        }
-        buffer_.push_back(input);
+        slot.info = this->stamp();
+        bool overwritten = buffer_.full() && this->overwrites();
+        if (buffer_.full() && !makeRoom())
+            return this->overflow();
+        buffer_.push_back(std::move(slot));
+        this->updateHighWater(buffer_.size());
         this->data_status_ = NEW_DATA;
-        if (this->input_->isEvent() && !buffer_.full())
+        this->notify();
+        /* Data not yet read has been overwritten, the component has already been triggered */
+        if (this->input_->isEvent() && !overwritten)
             this->trigger();
 
         return true;
     }
 
-    unsigned int queueLength() const final
+    /*! \brief Called with the buffer full, apply the overflow policy.
+     *  Reader and writer share the thread, so ConnectionPolicy::BLOCK cannot wait and behaves as FAIL.
+     *  \return Wheter there is room for new data.
+     */
+    bool makeRoom()
     {
-        return buffer_.size();
+        if (this->overwrites())
+        {
+            buffer_.pop_front();
+            this->addDropped();
+            return true;
+        }
+        return false;
     }
-private:
-    boost::circular_buffer<T> buffer_;
+
+    boost::circular_buffer<SampleSlot<T> > buffer_;
 };
 
-/**
- * Specialized class for the type T
+/*! \brief Specialized class for the type T to manage ConnectionPolicy::BUFFER ConnectionPolicy::LOCK_FREE
  */
 template <class T>
 class ConnectionBufferLF : public ConnectionT<T>
@@ -467,325 +1052,1744 @@ public:
                        ConnectionPolicy policy)
         : ConnectionT<T>(in, out, policy)
     {
-        queue_ = new boost::lockfree::spsc_queue<T>(policy.buffer_size);
+        queue_ = new boost::lockfree::spsc_queue<SampleSlot<T> >(policy.buffer_size);
     }
 
     FlowStatus newestData(T & data)
     {
         bool once = false;
-        while (queue_->pop(data))
+        SampleSlot<T> slot;
+        while (queue_->consume_one([&slot] (SampleSlot<T> &s) { slot = std::move(s); }))
+        {
+            popped_.fetch_add(1, std::memory_order_release);
             once = true;
+        }
+        this->reconcileTriggers(triggered_, queue_->read_available());
 
         if (once)
         {
-            /* Propagate timestamp to calculate latency */
-            int long latency_time = this->output_->task()->latencyTimestamp();
-            if (latency_time > 0)
-                this->input_->task()->setLatencyTimestamp(latency_time);
+            SampleInfo info;
+            slot.get(data, &info);
+            this->propagateLatency(&info);
         }
         return once ? NEW_DATA : NO_DATA;
     }
 
-    FlowStatus data(T & data) final
+    FlowStatus data(T &data) final
     {
-        bool new_data = queue_->pop(data);
-        if (new_data)
-        {
-            /* Propagate timestamp to calculate latency */
-            int long latency_time = this->output_->task()->latencyTimestamp();
-            if (latency_time > 0)
-                this->input_->task()->setLatencyTimestamp(latency_time);
-            return NEW_DATA;
-        }
-        return NO_DATA;
+        return readData(data);
+    }
+
+    FlowStatus data(T &data, SampleInfo &info) final
+    {
+        return readData(data, &info);
+    }
+
+    FlowStatus sample(std::shared_ptr<const T> &data) final
+    {
+        return readData(data);
     }
 
     bool addData(const T &input) final
     {
-        if (!queue_->push(input))
+        return addSlot(SampleSlot<T>(input));
+    }
+
+    bool addSample(const std::shared_ptr<const T> &input) final
+    {
+        return addSlot(SampleSlot<T>(input));
+    }
+
+    unsigned int dataN(T *data, unsigned int n) final
+    {
+        unsigned int count = 0;
+        SampleInfo info;
+        while (count < n &&
+               queue_->consume_one([&] (SampleSlot<T> &s) { s.get(data[count], &info); }))
+            ++count;
+        popped_.fetch_add(count, std::memory_order_release);
+        this->reconcileTriggers(triggered_, queue_->read_available());
+
+        if (count > 0)
+            this->propagateLatency(&info);
+        return count;
+    }
+
+    unsigned int addDataN(const T *data, unsigned int n) final
+    {
+        SampleInfo info = this->stamp(n);
+        unsigned int count = 0;
+        for (; count < n; ++count, ++info.sequence)
         {
-            if (this->policy_.data_policy == ConnectionPolicy::CIRCULAR)
-            {
-                T dummy;
-                queue_->pop(dummy);
-                queue_->push(input);
-            }
-            else
+            SampleSlot<T> slot(data[count]);
+            slot.info = info;
+            if (!queue_->push(slot) && !this->retryPush([&] () { return queue_->push(slot); }))
             {
-                return false;
+                this->overflow(n - count);
+                break;
             }
         }
-        if (this->input_->isEvent())
-            this->trigger();
+        pushed_.fetch_add(count, std::memory_order_release);
+        updateHighWater();
+        if (count > 0)
+        {
+            this->notify(count);
+            this->countTriggers(triggered_, count);
+        }
 
-        return true;
+        return count;
     }
-
+    /*!
+     * \return The data pushed and not yet consumed. The counts are read without synchronizing with
+     *  the two sides, so it can be off by the operations in progress.
+     */
     unsigned int queueLength() const final
     {
-        //return queue_.size();
-        return 0;
+        uint64_t popped = popped_.load(std::memory_order_acquire);
+        uint64_t pushed = pushed_.load(std::memory_order_acquire);
+        return pushed > popped ? pushed - popped : 0;
     }
 private:
-    boost::lockfree::spsc_queue<T> *queue_;
-};
-
-
-/*! \brief Support strucut to create connection easily.
- */
-template <class T>
-struct MakeConnection
-{
-    static std::shared_ptr<ConnectionT<T> > fx(std::shared_ptr<InputPort<T> > &input,
-                                               std::shared_ptr<OutputPort<T> > &output,
-                                               ConnectionPolicy policy)
+    template <class D>
+    FlowStatus readData(D &data, SampleInfo *info = nullptr)
     {
-        switch (policy.lock_policy)
+        SampleInfo local_info;
+        if (!info)
+            info = &local_info;
+        SampleSlot<T> slot;
+        bool new_data = queue_->consume_one([&slot] (SampleSlot<T> &s) { slot = std::move(s); });
+        if (new_data)
+            popped_.fetch_add(1, std::memory_order_release);
+        this->reconcileTriggers(triggered_, queue_->read_available());
+        if (new_data)
         {
-            case ConnectionPolicy::LOCKED:
-                switch (policy.data_policy)
-                {
-                    case ConnectionPolicy::DATA:        return std::make_shared<ConnectionDataL<T> >(input, output, policy);
-                    case ConnectionPolicy::BUFFER:      return std::make_shared<ConnectionBufferL<T> >(input, output, policy);
-                    case ConnectionPolicy::CIRCULAR:    return std::make_shared<ConnectionBufferL<T> >(input, output, policy);
-                }
-                break;
-            case ConnectionPolicy::UNSYNC:
-                switch (policy.data_policy)
-                {
-                    case ConnectionPolicy::DATA:        return std::make_shared<ConnectionDataU<T> >(input, output, policy);
-                    case ConnectionPolicy::BUFFER:      return std::make_shared<ConnectionBufferU<T> >(input, output, policy);
-                    case ConnectionPolicy::CIRCULAR:    return std::make_shared<ConnectionBufferU<T> >(input, output, policy);
-                }
-                break;
-            case ConnectionPolicy::LOCK_FREE:
-                switch (policy.data_policy)
-                {
-                    case ConnectionPolicy::DATA:        return std::make_shared<ConnectionDataLF<T> >(input, output, policy);
-                    case ConnectionPolicy::BUFFER:      return std::make_shared<ConnectionBufferLF<T> >(input, output, policy);
-                    case ConnectionPolicy::CIRCULAR:    return std::make_shared<ConnectionBufferLF<T> >(input, output, policy);
-                }
-                break;
+            slot.get(data, info);
+            this->propagateLatency(info);
+            return NEW_DATA;
         }
-        return nullptr;
+        return NO_DATA;
     }
-};
 
-/*! \brief Factory to create the corect connection based on the policys.
- *  \param input The inpurt port.
- *  \param output The output port.
- *  \param policy The policy of the connection.
- *  \return Pointer to the new connection.
- */
-template <class T>
-std::shared_ptr<ConnectionT<T> > makeConnection(std::shared_ptr<InputPort<T> > input,
-                                                std::shared_ptr<OutputPort<T> > output,
-                                                ConnectionPolicy policy)
-{
-#ifdef PORT_INTROSPECTION
-    // MakeConnection<T>::fx(input, ) given the task inspection create a new port for him and go
-#endif
-    return MakeConnection<T>::fx(input, output, policy);
-}
-/*! \brief Factory to create the corect connection based on the policys.
- *  \param output The output port.
- *  \param input The inpurt port.
- *  \param policy The policy of the connection.
- *  \return Pointer to the new connection.
- */
-template <class T>
-std::shared_ptr<ConnectionT<T> > makeConnection(std::shared_ptr<OutputPort<T> > output,
-                                                std::shared_ptr<InputPort<T> > input,
-                                                ConnectionPolicy policy)
-{
-#ifdef PORT_INTROSPECTION
-    // MakeConnection<T>::fx(input, ) given the task inspection create a new port for him and go
-#endif
-    return MakeConnection<T>::fx(input, output, policy);
-}
+    bool addSlot(SampleSlot<T> &&slot)
+    {
+        slot.info = this->stamp();
+        if (!queue_->push(slot) && !this->retryPush([&] () { return queue_->push(slot); }))
+            return this->overflow();
+        pushed_.fetch_add(1, std::memory_order_release);
+        updateHighWater();
+        this->notify();
+        this->countTriggers(triggered_);
 
-/*! \brief Specialization for managing \p InputPort's connections
- */
-template <class T>
-class ConnectionManagerInputT : public ConnectionManager
-{
-public:
-    /*! \brief Read data from one connection, the policy depends on the specialization
-     *  \param data Variable where to store the data from the connection
-     *  \return Wheter new data was present in the connection
-     */
-    virtual FlowStatus read(T &data) = 0;
-    /*! \brief Read the data from all the connections associated with the port
-     *  \param data Vector where to store the data of all the connections. The order of the
-     * connections is the same as specified in the launch file
-     *  \return Wheter new data was present in the connections
-     */
-    virtual FlowStatus readAll(std::vector<T> &data) = 0;
-    /*! \brief Used to retreive a specific connection
-     *  \param idx Index of the desired connection
-     *  \return Shared ptr to the connection
-     */
-    std::shared_ptr<ConnectionT<T> > connection(unsigned idx)
+        return true;
+    }
+
+    /* The free space is available to the producer only */
+    void updateHighWater()
     {
-        assert(idx < connections_.size() && "trying to access a connection out of bound");
-        return std::static_pointer_cast<ConnectionT<T> >(connections_[idx]);
+        ConnectionBase::updateHighWater(this->policy_.buffer_size - queue_->write_available());
     }
+
+    boost::lockfree::spsc_queue<SampleSlot<T> > *queue_;
+    std::atomic<unsigned int> triggered_ = {0};  // Triggers added and not yet removed
+    /* The spsc_queue size is valid only from one of the two sides, the counts from any thread */
+    std::atomic<uint64_t> pushed_ = {0};
+    std::atomic<uint64_t> popped_ = {0};
 };
 
-/*! \brief Specialization for managing \p OutputPort's connections
+/*! \brief Specialized class for the type T to manage ConnectionPolicy::CIRCULAR ConnectionPolicy::LOCK_FREE
+ *  Overwrite-oldest ring for a single producer and a single consumer.
+ *  Each cell of the ring contains the index of a buffer and the sequence number of the
+ *  data it holds. Writer and reader own a spare buffer each and exchange it with a cell,
+ *  so a buffer is never accessed by both sides and both operations are wait-free.
+ *  When the reader is overtaken by the writer it skips to the oldest data still present.
  */
 template <class T>
-class ConnectionManagerOutputT : public ConnectionManager
+class ConnectionCircularLF : public ConnectionT<T>
 {
 public:
-    /*! \brief Write data in the associated connections, the policy depends on the specialization
-     *  \param data Variable to be written
-     *  \return Wheter the write succeded
-     */
-    virtual bool write(const T &data) = 0;
-    /*! \brief Write data in ports contained in a specific task
-     *  \param data The variable to be written
-     *  \param task_name The name of the task to wich we want to write data
-     *  \return Wheter the write succeded
-     */
-    virtual bool write(const T &data, const std::string &task_name) = 0;
-    /*! \brief Used to retreive a specific connection
-     *  \param idx Index of the desired connection
-     *  \return Shared ptr to the connection
-     */
-    std::shared_ptr<ConnectionT<T> > connection(unsigned idx)
+    ConnectionCircularLF(std::shared_ptr<InputPort<T> > in,
+                         std::shared_ptr<OutputPort<T> > out,
+                         ConnectionPolicy policy)
+        : ConnectionT<T>(in, out, policy),
+          size_(policy.buffer_size > 0 ? policy.buffer_size : 1),
+          buffers_(size_ + 2), cells_(size_)
     {
-        assert(idx < connections_.size() && "trying to access a connection out of bound");
-        return std::static_pointer_cast<ConnectionT<T> >(connections_[idx]);
+        if (size_ > INDEX_MASK - 2)
+            COCO_FATAL() << "Lock free circular buffer size too big: " << size_;
+        for (uint64_t i = 0; i < size_; ++i)
+            cells_[i].store(i);
+        write_spare_ = size_;
+        read_spare_ = size_ + 1;
     }
-};
-/*! \brief Default input connection manager
- */
-template <class T>
-class ConnectionManagerInputDefault : public ConnectionManagerInputT<T>
-{
-public:
-    /*! \brief Read data from a connection with a Round Robin scheduling
-     *  \param data Variable where to store the read value
-     *  \return Wheter new data was present in the connections
+
+    /*! \brief Remove all data in the buffer and return the last value
+     *  \param data The variable where to store data
      */
-    FlowStatus read(T &data) final
+    FlowStatus newestData(T &data)
     {
-        size_t size = this->connections_.size();
-        std::shared_ptr<ConnectionT<T> > conn;
+        uint64_t head = head_.load(std::memory_order_acquire);
+        if (head == tail_.load(std::memory_order_relaxed))
+            return NO_DATA;
+        tail_.store(head - 1, std::memory_order_relaxed);
+        return readData(data);
+    }
 
-        for (unsigned int i = 0; i < size; ++i)
-        {
-            conn = this->connection(this->rr_index_ % size);
+    FlowStatus data(T &data) final
+    {
+        return readData(data);
+    }
 
-            this->rr_index_ = (this->rr_index_ + 1) % size;
-            if (conn->data(data) == NEW_DATA)
-            {
-                return NEW_DATA;
-            }
-        }
-        return NO_DATA;
+    FlowStatus data(T &data, SampleInfo &info) final
+    {
+        return readData(data, &info);
     }
-    /*! \brief Read the data from all the connections associated with the port
-     *  \param data Vector where to store the data of all the connections. The order of the
-     * connections is the same as specified in the launch file
-     *  \return Wheter new data was present in the connections
+
+    FlowStatus sample(std::shared_ptr<const T> &data) final
+    {
+        return readData(data);
+    }
+
+    bool addData(const T &input) final
+    {
+        buffers_[write_spare_].value = input;
+        buffers_[write_spare_].sample.reset();
+        return triggerPush(push(this->stamp()));
+    }
+
+    bool addData(T &&input) final
+    {
+        buffers_[write_spare_].value = std::move(input);
+        buffers_[write_spare_].sample.reset();
+        return triggerPush(push(this->stamp()));
+    }
+
+    bool addSample(const std::shared_ptr<const T> &input) final
+    {
+        buffers_[write_spare_].sample = input;
+        return triggerPush(push(this->stamp()));
+    }
+
+    unsigned int dataN(T *data, unsigned int n) final
+    {
+        unsigned int count = 0;
+        SampleInfo info;
+        while (count < n && pop(data[count], &info))
+            ++count;
+        this->reconcileTriggers(triggered_, queueLength());
+
+        if (count > 0)
+            this->propagateLatency(&info);
+        return count;
+    }
+
+    unsigned int addDataN(const T *data, unsigned int n) final
+    {
+        unsigned int triggers = 0;  // Overwritten data has already triggered the component
+        SampleInfo info = this->stamp(n);
+        for (unsigned int i = 0; i < n; ++i, ++info.sequence)
+        {
+            buffers_[write_spare_].value = data[i];
+            buffers_[write_spare_].sample.reset();
+            if (!push(info))
+                ++triggers;
+        }
+        if (n > 0)
+        {
+            this->notify(n);
+            this->countTriggers(triggered_, triggers);
+        }
+        return n;
+    }
+
+    unsigned int queueLength() const final
+    {
+        uint64_t length = head_.load(std::memory_order_relaxed) -
+                          tail_.load(std::memory_order_relaxed);
+        return length < size_ ? length : size_;
+    }
+private:
+    /* A cell contains the buffer index in the low bits and the sequence number + 1
+     * of its data in the high bits, 0 if the data has already been read. */
+    enum : uint64_t { INDEX_BITS = 16, INDEX_MASK = (1 << INDEX_BITS) - 1 };
+
+    template <class D>
+    FlowStatus readData(D &data, SampleInfo *info = nullptr)
+    {
+        SampleInfo local_info;
+        if (!info)
+            info = &local_info;
+        bool new_data = pop(data, info);
+        this->reconcileTriggers(triggered_, queueLength());
+        if (!new_data)
+            return NO_DATA;
+
+        this->propagateLatency(info);
+        return NEW_DATA;
+    }
+
+    template <class D>
+    bool pop(D &data, SampleInfo *info = nullptr)
+    {
+        uint64_t head = head_.load(std::memory_order_acquire);
+        uint64_t tail = tail_.load(std::memory_order_relaxed);
+        if (head == tail)
+            return false;
+        if (head - tail > size_)
+            tail = head - size_;
+
+        uint64_t cell = cells_[tail % size_].exchange(read_spare_, std::memory_order_acq_rel);
+        read_spare_ = cell & INDEX_MASK;
+        /* The cell contains data of sequence tail, or newer if the writer has overtaken us */
+        tail_.store(cell >> INDEX_BITS, std::memory_order_relaxed);
+
+        buffers_[read_spare_].get(data, info);
+        buffers_[read_spare_].sample.reset();
+        return true;
+    }
+    /*! \brief Publish the write spare buffer in the ring.
+     *  \param info The header of the data in the write spare buffer.
+     *  \return Wheter unread data has been overwritten.
+     */
+    bool push(const SampleInfo &info)
+    {
+        buffers_[write_spare_].info = info;
+        uint64_t head = head_.load(std::memory_order_relaxed);
+        uint64_t cell = cells_[head % size_].exchange(((head + 1) << INDEX_BITS) | write_spare_,
+                                                      std::memory_order_acq_rel);
+        write_spare_ = cell & INDEX_MASK;
+        head_.store(head + 1, std::memory_order_release);
+
+        bool overwritten = (cell >> INDEX_BITS) != 0;
+        if (overwritten)
+            this->addDropped();
+        uint64_t length = head + 1 - tail_.load(std::memory_order_relaxed);
+        this->updateHighWater(std::min<uint64_t>(length, size_));
+        return overwritten;
+    }
+
+    bool triggerPush(bool overwritten, unsigned int count = 1)
+    {
+        this->notify(count);
+        /* If unread data has been overwritten the component has already been triggered */
+        if (!overwritten)
+            this->countTriggers(triggered_);
+        return true;
+    }
+
+    const uint64_t size_;
+    std::vector<SampleSlot<T> > buffers_;
+    std::vector<std::atomic<uint64_t> > cells_;
+    std::atomic<uint64_t> head_ = {0};  // Sequence number of the next data to be written
+    std::atomic<uint64_t> tail_ = {0};  // Sequence number of the next data to be read
+    uint64_t write_spare_;  // Owned by the writer
+    uint64_t read_spare_;  // Owned by the reader
+    std::atomic<unsigned int> triggered_ = {0};  // Triggers added and not yet removed
+};
+
+/*! \brief Connection towards an input port with a ConnectionManagerType::FAN_IN manager.
+ *  All the connections of the port share the same util::MPSCQueue, so the reader
+ *  gets data from any of them in arrival order with a single pop.
+ *  The queue always behaves as ConnectionPolicy::BUFFER and it is lock free,
+ *  each connection adds its buffer size to the queue capacity.
+ */
+template <class T>
+class ConnectionFanIn : public ConnectionT<T>
+{
+public:
+    ConnectionFanIn(std::shared_ptr<InputPort<T> > in,
+                    std::shared_ptr<OutputPort<T> > out,
+                    ConnectionPolicy policy,
+                    std::shared_ptr<util::MPSCQueue<SampleSlot<T> > > queue,
+                    std::shared_ptr<std::atomic<unsigned int> > triggered)
+        : ConnectionT<T>(in, out, policy), queue_(queue), triggered_(triggered)
+    {
+        queue_->addCapacity(policy.data_policy == ConnectionPolicy::DATA ? 1 : policy.buffer_size);
+    }
+
+    FlowStatus data(T &data) final
+    {
+        return readData(data);
+    }
+
+    FlowStatus data(T &data, SampleInfo &info) final
+    {
+        return readData(data, &info);
+    }
+
+    FlowStatus sample(std::shared_ptr<const T> &data) final
+    {
+        return readData(data);
+    }
+
+    bool addData(const T &input) final
+    {
+        return addSlot(SampleSlot<T>(input));
+    }
+
+    bool addData(T &&input) final
+    {
+        return addSlot(SampleSlot<T>(std::move(input)));
+    }
+
+    bool addSample(const std::shared_ptr<const T> &input) final
+    {
+        return addSlot(SampleSlot<T>(input));
+    }
+    unsigned int dataN(T *data, unsigned int n) final
+    {
+        unsigned int count = 0;
+        SampleSlot<T> slot;
+        SampleInfo info;
+        while (count < n && queue_->pop(slot))
+            slot.get(data[count++], &info);
+        this->reconcileTriggers(*triggered_, queue_->size());
+        if (count > 0)
+            this->propagateLatency(&info);
+        return count;
+    }
+
+    unsigned int addDataN(const T *data, unsigned int n) final
+    {
+        SampleInfo info = this->stamp(n);
+        unsigned int count = 0;
+        for (; count < n; ++count, ++info.sequence)
+        {
+            SampleSlot<T> slot(data[count]);
+            slot.info = info;
+            if (!queue_->push(std::move(slot)) &&
+                !this->retryPush([&] () { return queue_->push(std::move(slot)); }))
+            {
+                this->overflow(n - count);
+                break;
+            }
+        }
+        this->updateHighWater(queue_->size());
+        if (count > 0)
+        {
+            this->notify(count);
+            this->countTriggers(*triggered_, count);
+        }
+        return count;
+    }
+    /*!
+     * \return The number of data in the shared queue, coming from all the connections of the port.
+     */
+    unsigned int queueLength() const final
+    {
+        return queue_->size();
+    }
+private:
+    template <class D>
+    FlowStatus readData(D &data, SampleInfo *info = nullptr)
+    {
+        SampleInfo local_info;
+        if (!info)
+            info = &local_info;
+        SampleSlot<T> slot;
+        bool new_data = queue_->pop(slot);
+        this->reconcileTriggers(*triggered_, queue_->size());
+        if (!new_data)
+            return NO_DATA;
+        slot.get(data, info);
+        this->propagateLatency(info);
+        return NEW_DATA;
+    }
+
+    /* The shared queue is written by many producers, so the oldest data cannot be dropped
+     * and ConnectionPolicy::DROP_OLDEST behaves as FAIL */
+    bool addSlot(SampleSlot<T> &&slot)
+    {
+        slot.info = this->stamp();
+        if (!queue_->push(std::move(slot)) &&
+            !this->retryPush([&] () { return queue_->push(std::move(slot)); }))
+            return this->overflow();
+        this->updateHighWater(queue_->size());
+        this->notify();
+        this->countTriggers(*triggered_);
+        return true;
+    }
+
+    std::shared_ptr<util::MPSCQueue<SampleSlot<T> > > queue_;
+    std::shared_ptr<std::atomic<unsigned int> > triggered_;  // Shared by the connections as the queue
+};
+
+/*! \brief Connection between two tasks executed one after the other by the same activity,
+ *  used for any buffer policy when ConnectionPolicy::direct is set. The reader always runs after
+ *  the writer in the same step, so the data is handed over without locks and without triggering the
+ *  activity: written values are moved in the buffer and moved out by the reader, published samples are shared.
+ *  The activity is triggered only while the reader leaves data in the buffer, to be executed again.
+ */
+template <class T>
+class ConnectionDirect : public ConnectionT<T>
+{
+public:
+    ConnectionDirect(std::shared_ptr<InputPort<T> > in,
+                     std::shared_ptr<OutputPort<T> > out,
+                     ConnectionPolicy policy)
+        : ConnectionT<T>(in, out, policy),
+          buffer_(policy.data_policy == ConnectionPolicy::DATA ? 1 : std::max(policy.buffer_size, 1))
+    {}
+
+    FlowStatus data(T &data) final
+    {
+        return readData(data);
+    }
+
+    FlowStatus data(T &data, SampleInfo &info) final
+    {
+        return readData(data, &info);
+    }
+
+    FlowStatus sample(std::shared_ptr<const T> &data) final
+    {
+        return readData(data);
+    }
+
+    bool addData(const T &input) final
+    {
+        return addSlot(SampleSlot<T>(input));
+    }
+
+    bool addData(T &&input) final
+    {
+        return addSlot(SampleSlot<T>(std::move(input)));
+    }
+
+    bool addSample(const std::shared_ptr<const T> &input) final
+    {
+        return addSlot(SampleSlot<T>(input));
+    }
+
+    unsigned int dataN(T *data, unsigned int n) final
+    {
+        unsigned int count = 0;
+        SampleInfo info;
+        for (; count < n && !buffer_.empty(); ++count)
+        {
+            buffer_.front().get(data[count], &info);
+            buffer_.pop_front();
+        }
+        if (count > 0)
+        {
+            endRead();
+            this->propagateLatency(&info);
+        }
+        return count;
+    }
+
+    unsigned int addDataN(const T *data, unsigned int n) final
+    {
+        SampleInfo info = this->stamp(n);
+        unsigned int count = 0;
+        for (; count < n; ++count, ++info.sequence)
+        {
+            if (buffer_.full() && !makeRoom())
+            {
+                this->overflow(n - count);
+                break;
+            }
+            buffer_.push_back(SampleSlot<T>(data[count]));
+            buffer_.back().info = info;
+        }
+        if (count > 0)
+            endWrite(count);
+        return count;
+    }
+
+    unsigned int queueLength() const final
+    {
+        return buffer_.size();
+    }
+private:
+    template <class D>
+    FlowStatus readData(D &data, SampleInfo *info = nullptr)
+    {
+        SampleInfo local_info;
+        if (!info)
+            info = &local_info;
+        if (buffer_.empty())
+            return this->data_status_;
+        buffer_.front().get(data, info);
+        buffer_.pop_front();
+        endRead();
+        this->propagateLatency(info);
+        return NEW_DATA;
+    }
+
+    void endRead()
+    {
+        if (buffer_.empty())
+            this->data_status_ = OLD_DATA;
+        if (!this->input_->isEvent())
+            return;
+        if (triggered_ && buffer_.empty())
+        {
+            this->removeTrigger();
+            triggered_ = false;
+        }
+        else if (!triggered_ && !buffer_.empty())
+        {
+            this->trigger();
+            triggered_ = true;
+        }
+    }
+
+    bool addSlot(SampleSlot<T> &&slot)
+    {
+        slot.info = this->stamp();
+        if (buffer_.full() && !makeRoom())
+            return this->overflow();
+        buffer_.push_back(std::move(slot));
+        endWrite(1);
+        return true;
+    }
+
+    void endWrite(unsigned int count)
+    {
+        this->data_status_ = NEW_DATA;
+        this->updateHighWater(buffer_.size());
+        this->notify(count);
+    }
+    /*! \brief DATA keeps only the newest value, CIRCULAR and DROP_OLDEST discard the oldest one.
+     *  BLOCK cannot wait for a reader executed by the same thread, so it behaves as FAIL.
+     *  \return Wheter there is room for the new data.
+     */
+    bool makeRoom()
+    {
+        if (this->policy_.data_policy != ConnectionPolicy::DATA)
+        {
+            if (!this->overwrites())
+                return false;
+            this->addDropped();
+        }
+        buffer_.pop_front();
+        return true;
+    }
+
+    boost::circular_buffer<SampleSlot<T> > buffer_;
+    bool triggered_ = false;  // The activity has been triggered for the data left in the buffer
+};
+
+template <class T>
+class ConnectionWorkQueue;
+
+/*! \brief Queue shared by the ConnectionPolicy::WORK_QUEUE connections of an output port,
+ *  together with the connections reading from it.
+ */
+template <class T>
+struct WorkQueue
+{
+    explicit WorkQueue(size_t capacity) : queue(capacity) {}
+
+    util::MPMCQueue<SampleSlot<T> > queue;
+    std::vector<ConnectionWorkQueue<T> *> readers;  //!< In creation order, the first one pushes the data.
+};
+
+/*! \brief Connection for ConnectionPolicy::WORK_QUEUE. All the work queue connections of an output port
+ *  share a single util::MPMCQueue and each data is read by only one of the input ports (competing consumers).
+ *  The output port writes in all its connections, but only the first connection of the queue pushes the data
+ *  and it is the one the output port moves the data in.
+ *  A push triggers one of the input ports waiting for data, preferring the ones whose task is idle,
+ *  the others are busy and they get the data with their next read. A reader stays triggered
+ *  until it finds the queue empty, so also a task reading one data per execution drains the queue.
+ */
+template <class T>
+class ConnectionWorkQueue : public ConnectionT<T>
+{
+public:
+    ConnectionWorkQueue(std::shared_ptr<InputPort<T> > in,
+                        std::shared_ptr<OutputPort<T> > out,
+                        ConnectionPolicy policy,
+                        std::shared_ptr<WorkQueue<T> > work_queue)
+        : ConnectionT<T>(in, out, policy), work_queue_(work_queue)
+    {
+        work_queue_->readers.push_back(this);
+    }
+
+    ~ConnectionWorkQueue()
+    {
+        auto &readers = work_queue_->readers;
+        readers.erase(std::remove(readers.begin(), readers.end(), this), readers.end());
+    }
+
+    FlowStatus data(T &data) final
+    {
+        return readData(data);
+    }
+
+    FlowStatus data(T &data, SampleInfo &info) final
+    {
+        return readData(data, &info);
+    }
+
+    FlowStatus sample(std::shared_ptr<const T> &data) final
+    {
+        return readData(data);
+    }
+
+    bool addData(const T &input) final
+    {
+        return leader() && addSlot(SampleSlot<T>(input));
+    }
+
+    bool addData(T &&input) final
+    {
+        return leader() && addSlot(SampleSlot<T>(std::move(input)));
+    }
+
+    bool addSample(const std::shared_ptr<const T> &input) final
+    {
+        return leader() && addSlot(SampleSlot<T>(input));
+    }
+
+    unsigned int dataN(T *data, unsigned int n) final
+    {
+        unsigned int count = 0;
+        SampleSlot<T> slot;
+        SampleInfo info;
+        while (count < n && work_queue_->queue.pop(slot))
+            slot.get(data[count++], &info);
+        endRead();
+        if (count > 0)
+            this->propagateLatency(&info);
+        return count;
+    }
+
+    unsigned int addDataN(const T *data, unsigned int n) final
+    {
+        if (!leader())
+            return 0;
+        auto &queue = work_queue_->queue;
+        SampleInfo info = this->stamp(n);
+        unsigned int count = 0;
+        for (; count < n; ++count, ++info.sequence)
+        {
+            SampleSlot<T> slot(data[count]);
+            slot.info = info;
+            if (!queue.push(std::move(slot)) &&
+                !this->retryPush([&] () { return queue.push(std::move(slot)); }))
+            {
+                this->overflow(n - count);
+                break;
+            }
+        }
+        if (count > 0)
+            wake(count);
+        return count;
+    }
+    /*!
+     * \return The number of data in the shared queue, not yet read by any of the input ports.
+     */
+    unsigned int queueLength() const final
+    {
+        return work_queue_->queue.size();
+    }
+    /*!
+     * \return True only for the connection pushing in the shared queue, the output port moves data in it.
+     */
+    bool storesData() const final
+    {
+        return leader();
+    }
+private:
+    /*!
+     * \return Wheter this connection pushes the data written by the output port.
+     */
+    bool leader() const
+    {
+        return work_queue_->readers.front() == this;
+    }
+
+    template <class D>
+    FlowStatus readData(D &data, SampleInfo *info = nullptr)
+    {
+        SampleInfo local_info;
+        if (!info)
+            info = &local_info;
+        SampleSlot<T> slot;
+        bool popped = work_queue_->queue.pop(slot);
+        endRead();
+        if (!popped)
+            return NO_DATA;
+        slot.get(data, info);
+        this->propagateLatency(info);
+        return NEW_DATA;
+    }
+    /*! \brief Keep the reader triggered while there is data in the queue, otherwise ask to be woken
+     *  by the next push. The reader holds at most one trigger, while \ref waiting_ is false, and
+     *  whoever moves the flag from true to false adds it, so it is removed only once.
+     *  The check of the queue after marking the reader as waiting pairs with the check of the
+     *  waiting readers after a push, so that data pushed meanwhile is not missed.
+     */
+    void endRead()
+    {
+        if (work_queue_->queue.size() == 0)
+        {
+            if (!waiting_.exchange(true, std::memory_order_seq_cst) && this->input_->isEvent())
+                this->removeTrigger();
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (work_queue_->queue.size() == 0)
+                return;
+        }
+        if (waiting_.exchange(false, std::memory_order_seq_cst) && this->input_->isEvent())
+            this->trigger();
+    }
+
+    bool addSlot(SampleSlot<T> &&slot)
+    {
+        auto &queue = work_queue_->queue;
+        slot.info = this->stamp();
+        if (!queue.push(std::move(slot)) &&
+            !this->retryPush([&] () { return queue.push(std::move(slot)); }))
+            return this->overflow();
+        wake(1);
+        return true;
+    }
+    /*! \brief Account for the data pushed and trigger up to \p count waiting readers, the idle ones first.
+     */
+    void wake(unsigned int count)
+    {
+        this->written_.fetch_add(count, std::memory_order_relaxed);
+        this->updateHighWater(work_queue_->queue.size());
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        for (int idle = 1; idle >= 0 && count > 0; --idle)
+        {
+            for (auto reader : work_queue_->readers)
+            {
+                if (count == 0)
+                    break;
+                if (!reader->waiting_.load(std::memory_order_relaxed))
+                    continue;
+                if (idle && reader->input_->task()->state() != TaskState::IDLE)
+                    continue;
+                if (!reader->waiting_.exchange(false, std::memory_order_seq_cst))
+                    continue;
+                reader->notify(0);
+                if (reader->input_->isEvent())
+                    reader->trigger();
+                --count;
+            }
+        }
+    }
+
+    std::shared_ptr<WorkQueue<T> > work_queue_;
+    std::atomic<bool> waiting_ = {true};  // The reader holds no trigger and waits for one
+};
+
+/*! \brief Specialized class for the type T to manage ConnectionPolicy::IPC
+ *  Data is copied in a util::SharedMemoryRing, so the two ports can be in different processes.
+ *  The port living in the other process is null. All the buffer policies are supported,
+ *  DATA is a ring of size one that is always overwritten. Each element of the ring contains
+ *  the SampleInfo header followed by the data.
+ *  If the input port is an event port, a thread waits on the ring futex and triggers the
+ *  component when data is pushed by any process.
+ */
+template <class T>
+class ConnectionIPC : public ConnectionT<T>
+{
+public:
+    ConnectionIPC(std::shared_ptr<InputPort<T> > in,
+                  std::shared_ptr<OutputPort<T> > out,
+                  ConnectionPolicy policy)
+        : ConnectionT<T>(in, out, policy),
+          ring_(policy.name_id,
+                policy.data_policy == ConnectionPolicy::DATA ? 1 : policy.buffer_size,
+                sizeof(Element), policy.data_policy != ConnectionPolicy::BUFFER ||
+                           policy.overflow == ConnectionPolicy::DROP_OLDEST)
+    {
+        if (!ring_.isValid())
+            COCO_FATAL() << "Failed to create IPC connection: " << policy.name_id;
+        if (this->input_ && this->input_->isEvent())
+            waiter_ = std::thread(&ConnectionIPC<T>::waitData, this);
+    }
+    /*! \brief Wake up and join the thread waiting for data.
+     */
+    ~ConnectionIPC()
+    {
+        if (waiter_.joinable())
+        {
+            stopping_ = true;
+            ring_.wakeAll();
+            waiter_.join();
+        }
+    }
+    /*! \brief Remove all data in the buffer and return the last value
+     *  \param data The variable where to store data
+     */
+    FlowStatus newestData(T &data)
+    {
+        Element element;
+        if (!ring_.popNewest(&element))
+            return NO_DATA;
+        data = element.value;
+        this->propagateLatency(&element.info);
+        if (this->input_->isEvent())
+        {
+            while (triggered_ > 0)
+            {
+                --triggered_;
+                this->removeTrigger();
+            }
+        }
+        return NEW_DATA;
+    }
+
+    FlowStatus data(T &data) final
+    {
+        return readData(data, nullptr);
+    }
+
+    FlowStatus data(T &data, SampleInfo &info) final
+    {
+        return readData(data, &info);
+    }
+
+    bool addData(const T &input) final
+    {
+        Element element;
+        element.info = this->stamp();
+        element.value = input;
+        if (!ring_.push(&element) && !this->retryPush([&] () { return ring_.push(&element); }))
+            return this->overflow();
+        this->notify();
+        return true;
+    }
+
+    unsigned int dataN(T *data, unsigned int n) final
+    {
+        if (read_batch_.size() < n)
+            read_batch_.resize(n);
+        unsigned int count = ring_.pop(read_batch_.data(), n);
+        for (unsigned int i = 0; i < count; ++i)
+            data[i] = read_batch_[i].value;
+        if (count > 0)
+            this->propagateLatency(&read_batch_[count - 1].info);
+        if (this->input_->isEvent())
+        {
+            for (unsigned int i = 0; i < count && triggered_ > 0; ++i)
+            {
+                --triggered_;
+                this->removeTrigger();
+            }
+        }
+        return count;
+    }
+
+    unsigned int addDataN(const T *data, unsigned int n) final
+    {
+        if (write_batch_.size() < n)
+            write_batch_.resize(n);
+        SampleInfo info = this->stamp(n);
+        for (unsigned int i = 0; i < n; ++i, ++info.sequence)
+        {
+            write_batch_[i].info = info;
+            write_batch_[i].value = data[i];
+        }
+        unsigned int count = ring_.push(write_batch_.data(), n);
+        while (count < n && this->retryPush([&] () { return ring_.push(&write_batch_[count]); }))
+            ++count;
+        if (count < n)
+            this->overflow(n - count);
+        if (count > 0)
+            this->notify(count);
+        return count;
+    }
+
+    unsigned int queueLength() const final
+    {
+        return ring_.size();
+    }
+private:
+    /*! \brief Element of the shared memory ring.
+     */
+    struct Element
+    {
+        SampleInfo info;
+        T value;
+    };
+
+    FlowStatus readData(T &data, SampleInfo *info)
+    {
+        Element element;
+        if (!ring_.pop(&element))
+            return NO_DATA;
+        data = element.value;
+        if (info)
+            *info = element.info;
+        this->propagateLatency(&element.info);
+        if (this->input_->isEvent() && triggered_ > 0)
+        {
+            --triggered_;
+            this->removeTrigger();
+        }
+        return NEW_DATA;
+    }
+    /*! \brief Loop of the waiting thread. It keeps one trigger for each element
+     *  present in the ring, so overwritten data doesn't generate spurious triggers.
+     *  The ring may already contain data written before this process attached, if it is full
+     *  no push changes the sequence, so the data present is checked before waiting.
+     */
+    void waitData()
+    {
+        uint32_t sequence = ring_.sequence();
+        bool changed = true;
+        while (!stopping_)
+        {
+            if (changed)
+            {
+                this->notify(0);
+                unsigned int size = ring_.size();
+                while (triggered_ < size)
+                {
+                    ++triggered_;
+                    this->trigger();
+                }
+            }
+            uint32_t new_sequence = ring_.wait(sequence, 100);
+            changed = new_sequence != sequence;
+            sequence = new_sequence;
+        }
+    }
+
+    util::SharedMemoryRing ring_;
+    std::vector<Element> read_batch_;   // Used by dataN() to pop the elements in a single access
+    std::vector<Element> write_batch_;  // Used by addDataN() to push the elements in a single access
+    std::thread waiter_;
+    std::atomic<bool> stopping_ = {false};
+    std::atomic<unsigned int> triggered_ = {0};
+};
+
+/*! \brief Support struct to create IPC connections only for types that can be copied in shared memory.
+ */
+template <class T, bool trivially_copyable = std::is_trivially_copyable<T>::value>
+struct MakeConnectionIPC
+{
+    static std::shared_ptr<ConnectionT<T> > fx(std::shared_ptr<InputPort<T> > &input,
+                                               std::shared_ptr<OutputPort<T> > &output,
+                                               ConnectionPolicy policy)
+    {
+        COCO_FATAL() << "Connection " << policy.name_id << ": IPC transport requires a trivially "
+                     << "copyable type, " << typeid(T).name() << " is not.";
+        return nullptr;
+    }
+};
+
+template <class T>
+struct MakeConnectionIPC<T, true>
+{
+    static std::shared_ptr<ConnectionT<T> > fx(std::shared_ptr<InputPort<T> > &input,
+                                               std::shared_ptr<OutputPort<T> > &output,
+                                               ConnectionPolicy policy)
+    {
+        return std::make_shared<ConnectionIPC<T> >(input, output, policy);
+    }
+};
+
+/*! \brief Support strucut to create connection easily.
+ */
+template <class T>
+struct MakeConnection
+{
+    static std::shared_ptr<ConnectionT<T> > fx(std::shared_ptr<InputPort<T> > &input,
+                                               std::shared_ptr<OutputPort<T> > &output,
+                                               ConnectionPolicy policy)
+    {
+        if (policy.data_policy == ConnectionPolicy::WORK_QUEUE)
+        {
+            if (policy.transport == ConnectionPolicy::IPC || !input || !output)
+                COCO_FATAL() << "Connection " << policy.name_id << ": WORK_QUEUE policy requires LOCAL transport";
+            if (input->fanInManager())
+                COCO_FATAL() << "Port " << input->name() << " with fan in manager cannot have WORK_QUEUE connections";
+            if (!output->work_queue_)
+                output->work_queue_ = std::make_shared<WorkQueue<T> >(std::max(policy.buffer_size, 1));
+            return std::make_shared<ConnectionWorkQueue<T> >(input, output, policy, output->work_queue_);
+        }
+        if (input)
+        {
+            if (auto fan_in = input->fanInManager())
+            {
+                if (policy.transport == ConnectionPolicy::IPC)
+                    COCO_FATAL() << "Port " << input->name() << " with fan in manager cannot have IPC connections";
+                return std::make_shared<ConnectionFanIn<T> >(input, output, policy, fan_in->queue(), fan_in->triggered());
+            }
+        }
+        if (policy.transport == ConnectionPolicy::IPC)
+            return MakeConnectionIPC<T>::fx(input, output, policy);
+        if (policy.direct)
+            return std::make_shared<ConnectionDirect<T> >(input, output, policy);
+
+        switch (policy.lock_policy)
+        {
+            case ConnectionPolicy::LOCKED:
+                switch (policy.data_policy)
+                {
+                    case ConnectionPolicy::DATA:        return std::make_shared<ConnectionDataL<T> >(input, output, policy);
+                    case ConnectionPolicy::BUFFER:      return std::make_shared<ConnectionBufferL<T> >(input, output, policy);
+                    case ConnectionPolicy::CIRCULAR:    return std::make_shared<ConnectionBufferL<T> >(input, output, policy);
+                    default: break;
+                }
+                break;
+            case ConnectionPolicy::UNSYNC:
+                switch (policy.data_policy)
+                {
+                    case ConnectionPolicy::DATA:        return std::make_shared<ConnectionDataU<T> >(input, output, policy);
+                    case ConnectionPolicy::BUFFER:      return std::make_shared<ConnectionBufferU<T> >(input, output, policy);
+                    case ConnectionPolicy::CIRCULAR:    return std::make_shared<ConnectionBufferU<T> >(input, output, policy);
+                    default: break;
+                }
+                break;
+            case ConnectionPolicy::LOCK_FREE:
+                switch (policy.data_policy)
+                {
+                    case ConnectionPolicy::DATA:        return std::make_shared<ConnectionDataLF<T> >(input, output, policy);
+                    case ConnectionPolicy::BUFFER:
+                        /* Only the reader can pop from the spsc queue, use the overwrite-oldest ring */
+                        if (policy.overflow == ConnectionPolicy::DROP_OLDEST)
+                            return std::make_shared<ConnectionCircularLF<T> >(input, output, policy);
+                        return std::make_shared<ConnectionBufferLF<T> >(input, output, policy);
+                    case ConnectionPolicy::CIRCULAR:    return std::make_shared<ConnectionCircularLF<T> >(input, output, policy);
+                    default: break;
+                }
+                break;
+        }
+        return nullptr;
+    }
+};
+
+/*! \brief Factory to create the corect connection based on the policys.
+ *  \param input The inpurt port.
+ *  \param output The output port.
+ *  \param policy The policy of the connection.
+ *  \return Pointer to the new connection.
+ */
+template <class T>
+std::shared_ptr<ConnectionT<T> > makeConnection(std::shared_ptr<InputPort<T> > input,
+                                                std::shared_ptr<OutputPort<T> > output,
+                                                ConnectionPolicy policy)
+{
+#ifdef PORT_INTROSPECTION
+    // MakeConnection<T>::fx(input, ) given the task inspection create a new port for him and go
+#endif
+    return MakeConnection<T>::fx(input, output, policy);
+}
+/*! \brief Factory to create the corect connection based on the policys.
+ *  \param output The output port.
+ *  \param input The inpurt port.
+ *  \param policy The policy of the connection.
+ *  \return Pointer to the new connection.
+ */
+template <class T>
+std::shared_ptr<ConnectionT<T> > makeConnection(std::shared_ptr<OutputPort<T> > output,
+                                                std::shared_ptr<InputPort<T> > input,
+                                                ConnectionPolicy policy)
+{
+#ifdef PORT_INTROSPECTION
+    // MakeConnection<T>::fx(input, ) given the task inspection create a new port for him and go
+#endif
+    return MakeConnection<T>::fx(input, output, policy);
+}
+
+/*! \brief Specialization for managing \p InputPort's connections
+ */
+template <class T>
+class ConnectionManagerInputT : public ConnectionManager
+{
+public:
+    /*! \brief Read data from one connection, the policy depends on the specialization
+     *  \param data Variable where to store the data from the connection
+     *  \return Wheter new data was present in the connection
+     */
+    virtual FlowStatus read(T &data) = 0;
+    /*! \brief Read data and its header from one connection, the policy depends on the specialization
+     *  \param data Variable where to store the data from the connection
+     *  \param info Variable where to store the timestamp and sequence number of the data
+     *  \return Wheter new data was present in the connection
+     */
+    virtual FlowStatus read(T &data, SampleInfo &info) = 0;
+    /*! \brief Read a read-only sample from one connection, the policy depends on the specialization
+     *  \param data Shared pointer where to store the sample
+     *  \return Wheter new data was present in the connection
+     */
+    virtual FlowStatus read(std::shared_ptr<const T> &data) = 0;
+    /*! \brief Read the data from all the connections associated with the port
+     *  \param data Vector where to store the data of all the connections. The order of the
+     * connections is the same as specified in the launch file
+     *  \return Wheter new data was present in the connections
+     */
+    virtual FlowStatus readAll(std::vector<T> &data) = 0;
+    /*! \brief Read up to \p n data from the associated connections, accessing each connection once.
+     *  \param data Array of at least \p n elements where to store the read values
+     *  \param n Maximum number of data to read
+     *  \return The number of data read
+     */
+    virtual unsigned int readN(T *data, unsigned int n) = 0;
+    /*! \brief Used to retreive a specific connection
+     *  \param idx Index of the desired connection
+     *  \return Shared ptr to the connection
+     */
+    std::shared_ptr<ConnectionT<T> > connection(unsigned idx)
+    {
+        assert(idx < connections_.size() && "trying to access a connection out of bound");
+        return std::static_pointer_cast<ConnectionT<T> >(connections_[idx]);
+    }
+};
+
+/*! \brief Specialization for managing \p OutputPort's connections
+ */
+template <class T>
+class ConnectionManagerOutputT : public ConnectionManager
+{
+public:
+    /*! \brief Write data in the associated connections, the policy depends on the specialization
+     *  \param data Variable to be written
+     *  \return Wheter the write succeded
+     */
+    virtual bool write(const T &data) = 0;
+    /*! \brief Same as \ref write(const T &) but \p data can be moved in one of the connections
+     *  \param data Variable to be written
+     *  \return Wheter the write succeded
+     */
+    virtual bool write(T &&data) = 0;
+    /*! \brief Write data in ports contained in a specific task
+     *  \param data The variable to be written
+     *  \param task_name The name of the task to wich we want to write data
+     *  \return Wheter the write succeded
+     */
+    virtual bool write(const T &data, const std::string &task_name) = 0;
+    /*! \brief Share a sample with the associated connections, the policy depends on the specialization
+     *  \param data The sample to be published
+     *  \return Wheter the write succeded
+     */
+    virtual bool publish(const std::shared_ptr<const T> &data) = 0;
+    /*! \brief Write a batch of data in the associated connections, accessing each of them once
+     *  \param data Array of \p n elements to be written
+     *  \param n Number of elements to be written
+     *  \return Wheter the write succeded
+     */
+    virtual bool writeBatch(const T *data, unsigned int n) = 0;
+    /*! \brief Used to retreive a specific connection
+     *  \param idx Index of the desired connection
+     *  \return Shared ptr to the connection
+     */
+    std::shared_ptr<ConnectionT<T> > connection(unsigned idx)
+    {
+        assert(idx < connections_.size() && "trying to access a connection out of bound");
+        return std::static_pointer_cast<ConnectionT<T> >(connections_[idx]);
+    }
+};
+/*! \brief Default input connection manager
+ */
+template <class T>
+class ConnectionManagerInputDefault : public ConnectionManagerInputT<T>
+{
+public:
+    /*! \brief Read data from a connection with a Round Robin scheduling
+     *  \param data Variable where to store the read value
+     *  \return Wheter new data was present in the connections
+     */
+    FlowStatus read(T &data) final
+    {
+        size_t size = this->connections_.size();
+        std::shared_ptr<ConnectionT<T> > conn;
+
+        for (unsigned int i = 0; i < size; ++i)
+        {
+            conn = this->connection(this->rr_index_ % size);
+
+            this->rr_index_ = (this->rr_index_ + 1) % size;
+            if (conn->data(data) == NEW_DATA)
+            {
+                conn->addRead();
+                return NEW_DATA;
+            }
+        }
+        return NO_DATA;
+    }
+
+    FlowStatus read(T &data, SampleInfo &info) final
+    {
+        size_t size = this->connections_.size();
+        std::shared_ptr<ConnectionT<T> > conn;
+
+        for (unsigned int i = 0; i < size; ++i)
+        {
+            conn = this->connection(this->rr_index_ % size);
+
+            this->rr_index_ = (this->rr_index_ + 1) % size;
+            if (conn->data(data, info) == NEW_DATA)
+            {
+                conn->addRead();
+                return NEW_DATA;
+            }
+        }
+        return NO_DATA;
+    }
+    /*! \brief Read a sample from a connection with a Round Robin scheduling
+     *  \param data Shared pointer where to store the read sample
+     *  \return Wheter new data was present in the connections
+     */
+    FlowStatus read(std::shared_ptr<const T> &data) final
+    {
+        size_t size = this->connections_.size();
+        std::shared_ptr<ConnectionT<T> > conn;
+
+        for (unsigned int i = 0; i < size; ++i)
+        {
+            conn = this->connection(this->rr_index_ % size);
+
+            this->rr_index_ = (this->rr_index_ + 1) % size;
+            if (conn->sample(data) == NEW_DATA)
+            {
+                conn->addRead();
+                return NEW_DATA;
+            }
+        }
+        return NO_DATA;
+    }
+    /*! \brief Read the data from all the connections associated with the port
+     *  \param data Vector where to store the data of all the connections. The order of the
+     * connections is the same as specified in the launch file
+     *  \return Wheter new data was present in the connections
+     */
+    FlowStatus readAll(std::vector<T> &data) final
+    {
+        T toutput;
+        data.clear();
+
+        for (unsigned int i = 0; i < this->connections_.size(); ++i)
+        {
+            auto conn = this->connection(i);
+            while (conn->data(toutput) == NEW_DATA)
+            {
+                data.push_back(std::move(toutput));
+                conn->addRead();
+            }
+        }
+        return data.empty() ? NO_DATA : NEW_DATA;
+    }
+    /*! \brief Read up to \p n data starting from the next connection in Round Robin order.
+     *  Each connection is drained with a single access before moving to the next one.
+     */
+    unsigned int readN(T *data, unsigned int n) final
+    {
+        size_t size = this->connections_.size();
+        unsigned int count = 0;
+        for (unsigned int i = 0; i < size && count < n; ++i)
+        {
+            auto conn = this->connection(this->rr_index_ % size);
+            this->rr_index_ = (this->rr_index_ + 1) % size;
+            unsigned int read = conn->dataN(data + count, n - count);
+            conn->addRead(read);
+            count += read;
+        }
+        return count;
+    }
+private:
+    unsigned int rr_index_ = 0;
+};
+
+template <class T>
+class ConnectionManagerOutputDefault : public ConnectionManagerOutputT<T>
+{
+public:
+    /*! \brief Write data in all the associated connections. Broadcast connections
+     *  share a single read-only sample built once, the others store a copy of data.
+     *  \param data Variable to be written
+     *  \return Wheter the write succeded
+     */
+    bool write(const T &data) final
+    {
+        bool written = false;
+        std::shared_ptr<const T> sample;
+        for (unsigned int i = 0; i < this->connections_.size(); ++i)
+        {
+            auto conn = this->connection(i);
+            if (conn->policy().broadcast)
+            {
+                if (!sample)
+                    sample = std::make_shared<const T>(data);
+                written = conn->addSample(sample) || written;
+            }
+            else
+            {
+                written = conn->addData(data) || written;
+            }
+        }
+        return written;
+    }
+    /*! \brief Write data in all the associated connections. Data is copied in all the connections
+     *  but the last one storing it, see ConnectionT::storesData(), that takes the ownership of it.
+     *  If all the connections are broadcast the shared sample takes the ownership of data.
+     *  \param data Variable to be written
+     *  \return Wheter the write succeded
+     */
+    bool write(T &&data) final
+    {
+        unsigned int size = this->connections_.size();
+        int last = -1;  // Last non broadcast connection storing the data
+        bool broadcast = false;
+        for (unsigned int i = 0; i < size; ++i)
+        {
+            auto conn = this->connection(i);
+            if (conn->policy().broadcast)
+                broadcast = true;
+            else if (conn->storesData())
+                last = i;
+        }
+        std::shared_ptr<const T> sample;
+        if (broadcast)
+            sample = last < 0 ? std::make_shared<const T>(std::move(data))
+                              : std::make_shared<const T>(data);
+
+        bool written = false;
+        for (unsigned int i = 0; i < size; ++i)
+        {
+            auto conn = this->connection(i);
+            if (conn->policy().broadcast)
+                written = conn->addSample(sample) || written;
+            else if (static_cast<int>(i) == last)
+                written = conn->addData(std::move(data)) || written;
+            else
+                written = conn->addData(data) || written;
+        }
+        return written;
+    }
+    /*! \brief Write data in ports contained in a specific task
+     *  \param data The variable to be written
+     *  \param task_name The name of the task to wich we want to write data
+     *  \return Wheter the write succeded
+     */
+    bool write(const T &data, const std::string &task_name) final
+    {
+        for (unsigned int i = 0; i < this->connections_.size(); ++i)
+        {
+            if (this->connection(i)->hasComponent(task_name))
+                return this->connection(i)->addData(data);
+        }
+        return false;
+    }
+    /*! \brief Share the sample with all the associated connections, without copying it
+     *  \param data The sample to be published
+     *  \return Wheter the write succeded
+     */
+    bool publish(const std::shared_ptr<const T> &data) final
+    {
+        bool written = false;
+        for (unsigned int i = 0; i < this->connections_.size(); ++i)
+        {
+            written = this->connection(i)->addSample(data) || written;
+        }
+        return written;
+    }
+    /*! \brief Write the batch in all the associated connections with a single access for each
+     *  of them. Broadcast connections share the samples, built once for all of them.
      */
+    bool writeBatch(const T *data, unsigned int n) final
+    {
+        bool written = false;
+        std::vector<std::shared_ptr<const T> > samples;
+        for (unsigned int i = 0; i < this->connections_.size(); ++i)
+        {
+            auto conn = this->connection(i);
+            if (conn->policy().broadcast)
+            {
+                if (samples.empty())
+                {
+                    samples.reserve(n);
+                    for (unsigned int j = 0; j < n; ++j)
+                        samples.push_back(std::make_shared<const T>(data[j]));
+                }
+                for (auto &sample : samples)
+                    written = conn->addSample(sample) || written;
+            }
+            else
+            {
+                written = conn->addDataN(data, n) > 0 || written;
+            }
+        }
+        return written;
+    }
+};
+
+/*! \brief Input connection manager of the gather of a farm, each worker writes its results in its own connection.
+ *  With FarmPolicy::ordered the results are moved in a bounded reorder buffer and released in the order
+ *  the farm source dispatched the items. A missing result is waited until the buffer is full, until
+ *  a newer result has waited FarmPolicy::reorder_timeout or until the missing one is certainly older
+ *  than FarmPolicy::discard_old_data, that is when a newer result is.
+ *  The results left in the connections keep their trigger, and the gather is triggered once for each
+ *  result of the buffer it can release, so also a task reading one result per execution gets all of them.
+ *  While a missing result is waited a FarmAlarm triggers the gather when the wait ends.
+ *  Otherwise the connections are read with a Round Robin scheduling and there is no guarantee
+ *  on the order of delivery.
+ *  In both cases results arrived more than FarmPolicy::discard_old_data ms after the dispatch of
+ *  their item are discarded, so that a stuck worker does not deliver data that is no longer useful.
+ *  With FarmPolicy::speculation only the first result of an item dispatched twice is delivered.
+ */
+template <class T>
+class ConnectionManagerInputFarm : public ConnectionManagerInputT<T>
+{
+public:
+    FlowStatus read(T &data) final
+    {
+        SampleInfo info;
+        return readResult(data, info);
+    }
+
+    FlowStatus read(T &data, SampleInfo &info) final
+    {
+        return readResult(data, info);
+    }
+    /* The farm connections copy the data, so the sample is never shared with the workers */
+    FlowStatus read(std::shared_ptr<const T> &data) final
+    {
+        T value;
+        SampleInfo info;
+        if (readResult(value, info) != NEW_DATA)
+            return NO_DATA;
+        data = std::make_shared<const T>(std::move(value));
+        return NEW_DATA;
+    }
+
     FlowStatus readAll(std::vector<T> &data) final
     {
-        T toutput;
-        data.clear();
+        T value;
+        data.clear();
+        while (read(value) == NEW_DATA)
+            data.push_back(std::move(value));
+        return data.empty() ? NO_DATA : NEW_DATA;
+    }
+
+    unsigned int readN(T *data, unsigned int n) final
+    {
+        unsigned int count = 0;
+        while (count < n && read(data[count]) == NEW_DATA)
+            ++count;
+        return count;
+    }
+
+    uint64_t reorderedCount() const final { return reordered_.load(std::memory_order_relaxed); }
+    uint64_t discardedCount() const final { return discarded_.load(std::memory_order_relaxed); }
+
+private:
+    struct Result
+    {
+        T value;
+        SampleInfo info;
+    };
 
-        for (unsigned int i = 0; i < this->connections_.size(); ++i)
+    FlowStatus readResult(T &data, SampleInfo &info)
+    {
+        int long now = util::monotonicTime();
+        if (!this->farm_policy_.ordered)
+            return readUnordered(data, info, now);
+
+        collect(now);
+        discardExpired(now);
+        FlowStatus status = NO_DATA;
+        if (!pending_.empty() && releasable(pending_.front().info, now))
         {
-            while (this->connection(i)->data(toutput) == NEW_DATA)
-                data.push_back(toutput);
+            Result &head = pending_.front();
+            if (head.info.farm.sequence > 0)
+                next_ = head.info.farm.sequence + 1;
+            data = std::move(head.value);
+            info = head.info;
+            pending_.pop_front();
+            status = NEW_DATA;
         }
-        return data.empty() ? NO_DATA : NEW_DATA;
+        holdTriggers(now);
+        return status;
     }
-private:
-    unsigned int rr_index_ = 0;
-};
-
-template <class T>
-class ConnectionManagerOutputDefault : public ConnectionManagerOutputT<T>
-{
-public:
-    /*! \brief Write data in all the associated connections
-     *  \param data Variable to be written
-     *  \return Wheter the write succeded
+    /*!
+     * \return Wheter the head of the buffer can be released: it is the next result, or the older results
+     *  still in the workers are not waited anymore because the buffer is full or it has waited too long.
      */
-    bool write(const T &data) final
+    bool releasable(const SampleInfo &info, int long now) const
     {
-        bool written = false;
-        for (unsigned int i = 0; i < this->connections_.size(); ++i)
+        return info.farm.sequence <= next_ || pending_.size() >= reorderSize() ||
+               (this->farm_policy_.reorder_timeout > 0 &&
+                now - info.farm.timestamp > this->farm_policy_.reorder_timeout * 1000l);
+    }
+    /*!
+     * \return The time at which the result stops waiting for the older ones, because of
+     *  FarmPolicy::reorder_timeout or because they are expired. 0 if it waits until the buffer is full.
+     */
+    int long releaseTime(const SampleInfo &info) const
+    {
+        int long time = 0;
+        if (this->farm_policy_.reorder_timeout > 0)
+            time = info.farm.timestamp + this->farm_policy_.reorder_timeout * 1000l + 1;
+        if (this->farm_policy_.discard_old_data > 0 && info.farm.sequence > 0)
         {
-            written = this->connection(i)->addData(data) || written;
+            int long expire = info.farm.timestamp + this->farm_policy_.discard_old_data * 1000l + 1;
+            time = time > 0 ? std::min(time, expire) : expire;
         }
-        return written;
+        return time;
     }
-    /*! \brief Write data in ports contained in a specific task
-     *  \param data The variable to be written
-     *  \param task_name The name of the task to wich we want to write data
-     *  \return Wheter the write succeded
+    /*! \brief The results moved in the buffer have lost their trigger. Keep one trigger for each result
+     *  the next reads can release, none while waiting for a missing result, so the gather does not spin.
+     *  While waiting the alarm triggers the gather when the oldest result stops waiting, so the buffer
+     *  is released also when no other result arrives.
      */
-    bool write(const T &data, const std::string &task_name) final
+    void holdTriggers(int long now)
     {
-        for (unsigned int i = 0; i < this->connections_.size(); ++i)
+        auto port = this->connection(0)->input();
+        if (!port->isEvent())
+            return;
+        if (!alarm_)
+            alarm_ = std::make_shared<FarmAlarm>(port);
+        held_ += alarm_->takeFired();
+        unsigned int ready = 0;
+        uint64_t next = next_;
+        for (auto &result : pending_)
         {
-            if (this->connection(i)->hasComponent(task_name))
-                return this->connection(i)->addData(data);
+            uint64_t sequence = result.info.farm.sequence;
+            if (sequence > next && (ready > 0 || !releasable(result.info, now)))
+                break;
+            ++ready;
+            next = std::max(next, sequence + 1);
         }
-        return false;
+        for (; held_ < ready; ++held_)
+            port->triggerComponent();
+        for (; held_ > ready; --held_)
+            port->removeTriggerComponent();
+
+        int long release_time = ready == 0 && !pending_.empty() ? releaseTime(pending_.front().info) : 0;
+        if (release_time > 0)
+            alarm_->arm(release_time);
+        else
+            alarm_->disarm();
     }
-};
 
-template <class T>
-class ConnectionManagerInputFarm : public ConnectionManagerInputT<T>
-{
-public:
-     /*
-      * The behaviour is exactly the same as of normal read. We read from one connection
-      * iterating in a round robin fashion. The problem here is that there is no guarantee
-      * on the order of delivery
-      * The main problem is that there is no way to discard a message if it takes to much to be computed.
-      * Suppose the rate is 30Hz the component needs 100ms to compute -> 4 instantiation to be sure.
-      * If one of the farm worker stuck and spends 500ms computing, the gather will receive in any case that
-      * data and it cannot discard it even if it is arrived with half second delay
-      */
-    FlowStatus read(T &data) final
+    FlowStatus readUnordered(T &data, SampleInfo &info, int long now)
     {
         unsigned int size = this->connections_.size();
-        std::shared_ptr<ConnectionT<T> > conn;
-
         for (unsigned int i = 0; i < size; ++i)
         {
-            conn = this->connection(this->rr_index_ % size);
-
-            this->rr_index_ = (this->rr_index_ + 1) % size;
-            if (conn->data(data) == NEW_DATA)
+            auto conn = this->connection(rr_index_ % size);
+            rr_index_ = (rr_index_ + 1) % size;
+            while (conn->data(data, info) == NEW_DATA)
             {
-                return NEW_DATA;
+                conn->addRead();
+                if (!track(info, now))
+                    continue;
+                if (!expired(info, now))
+                    return NEW_DATA;
+                discarded_.fetch_add(1, std::memory_order_relaxed);
             }
         }
         return NO_DATA;
     }
-
-    FlowStatus readAll(std::vector<T> &data) final
+    /*! \brief Move the new results of the workers in the reorder buffer, until it is full.
+     */
+    void collect(int long now)
     {
-        T toutput;
-        data.clear();
-
+        Result result;
         for (unsigned int i = 0; i < this->connections_.size(); ++i)
         {
-            while (this->connection(i)->data(toutput) == NEW_DATA)
-                data.push_back(toutput);
+            auto conn = this->connection(i);
+            while (pending_.size() < reorderSize() && conn->data(result.value, result.info) == NEW_DATA)
+            {
+                conn->addRead();
+                insert(std::move(result), now);
+            }
         }
-        return data.empty() ? NO_DATA : NEW_DATA;
     }
 
-private:
+    void insert(Result &&result, int long now)
+    {
+        if (!track(result.info, now))
+            return;
+        uint64_t sequence = result.info.farm.sequence;
+        if (sequence > 0 && sequence < next_)
+        {
+            /* A newer result has already been released */
+            discarded_.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        if (expired(result.info, now))
+        {
+            /* The items dispatched before this one are expired too */
+            next_ = sequence + 1;
+            discarded_.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        if (sequence > next_)
+            reordered_.fetch_add(1, std::memory_order_relaxed);
+        auto it = std::upper_bound(pending_.begin(), pending_.end(), sequence,
+                                   [](uint64_t seq, const Result &r) { return seq < r.info.farm.sequence; });
+        pending_.insert(it, std::move(result));
+    }
+    /*! \brief Discard the results at the head of the buffer that are expired or older than a
+     *  released one. Results are sorted by dispatch time, so the check stops at the first valid one.
+     */
+    void discardExpired(int long now)
+    {
+        while (!pending_.empty())
+        {
+            const SampleInfo &info = pending_.front().info;
+            if (info.farm.sequence == 0 || (info.farm.sequence >= next_ && !expired(info, now)))
+                break;
+            next_ = std::max(next_, info.farm.sequence + 1);
+            discarded_.fetch_add(1, std::memory_order_relaxed);
+            pending_.pop_front();
+        }
+    }
+
+    /*! \brief With speculation tell the source that the item has a result.
+     *  \return False if the result is a duplicate of an item dispatched again, to be dropped.
+     */
+    bool track(const SampleInfo &info, int long now)
+    {
+        if (!this->farm_tracker_ || info.farm.sequence == 0)
+            return true;
+        return this->farm_tracker_->complete(info.farm.sequence, now - info.farm.timestamp);
+    }
+
+    bool expired(const SampleInfo &info, int long now) const
+    {
+        return this->farm_policy_.discard_old_data > 0 && info.farm.sequence > 0 &&
+               now - info.farm.timestamp > this->farm_policy_.discard_old_data * 1000l;
+    }
+
+    size_t reorderSize() const
+    {
+        return this->farm_policy_.reorder_size > 0 ? this->farm_policy_.reorder_size
+                                                   : 2 * this->connections_.size();
+    }
+
     unsigned int rr_index_ = 0;
+    uint64_t next_ = 1;  // Sequence of the next result to be released
+    std::deque<Result> pending_;  // Reorder buffer sorted by sequence
+    unsigned int held_ = 0;  // Triggers kept for the results in the buffer
+    std::shared_ptr<FarmAlarm> alarm_;
+    std::atomic<uint64_t> reordered_ = {0};
+    std::atomic<uint64_t> discarded_ = {0};
+};
+
+/*! \brief Hash of the key of a farm item, see FarmKey.
+ */
+template <class K>
+uint64_t farmKeyHash(const K &key)
+{
+    return std::hash<K>()(key);
+}
+
+/*! \brief Hash of the key used to route an item with the KEY_AFFINITY farm dispatch.
+ *  The key is the value returned by the member function key() of T, for the other types
+ *  it can be registered with COCO_FARM_KEY.
+ */
+template <class T, class Enable = void>
+struct FarmKey
+{
+    static const bool available = false;
+    static uint64_t key(const T &data) { return 0; }
+};
+
+template <class T>
+struct FarmKey<T, decltype(void(std::declval<const T &>().key()))>
+{
+    static const bool available = true;
+    static uint64_t key(const T &data) { return farmKeyHash(data.key()); }
 };
 
 template <class T>
@@ -794,40 +2798,542 @@ class ConnectionManagerOutputFarm : public ConnectionManagerOutputT<T>
 public:
     bool write(const T &data) final
     {
-        /* Write to a connection which is empty and whose task is idle
-         * auto tmp_rr_index_ = rr_index_; */
+        FarmTag tag;
+        auto conn_ptr = selectConnection(data, tag);
+        if (!conn_ptr)
+            return false;
+        if (this->farm_tracker_)
+            return dispatch(conn_ptr, tag, std::make_shared<const T>(data));
+        return conn_ptr->addData(data);
+    }
+
+    bool write(T &&data) final
+    {
+        FarmTag tag;
+        auto conn_ptr = selectConnection(data, tag);
+        if (!conn_ptr)
+            return false;
+        if (this->farm_tracker_)
+            return dispatch(conn_ptr, tag, std::make_shared<const T>(std::move(data)));
+        return conn_ptr->addData(std::move(data));
+    }
+
+    bool write(const T &data, const std::string &task_name) final
+    {
+        COCO_ERR() << "Don't use this function with a farm component!";
+        return false;
+    }
+
+    bool publish(const std::shared_ptr<const T> &data) final
+    {
+        FarmTag tag;
+        auto conn_ptr = selectConnection(*data, tag);
+        if (!conn_ptr)
+            return false;
+        if (this->farm_tracker_)
+            return dispatch(conn_ptr, tag, data);
+        return conn_ptr->addSample(data);
+    }
+    /* Each element is dispatched on its own to spread the batch among the workers */
+    bool writeBatch(const T *data, unsigned int n) final
+    {
+        bool written = false;
+        for (unsigned int i = 0; i < n; ++i)
+            written = write(data[i]) || written;
+        return written;
+    }
+
+    void setFarmPolicy(const FarmPolicy &policy) final
+    {
+        if (policy.dispatch == FarmPolicy::KEY_AFFINITY && !FarmKey<T>::available)
+            COCO_FATAL() << "Farm dispatch KEY_AFFINITY requires a key for type " << typeid(T).name()
+                         << ", add a member function key() or register one with COCO_FARM_KEY";
+        /* All the workers read from the same queue, a worker cannot be parked or chosen for a late item */
+        if (policy.dispatch == FarmPolicy::WORK_QUEUE &&
+            (policy.max_workers > policy.min_workers || policy.speculation > 0))
+            COCO_FATAL() << "Farm dispatch WORK_QUEUE cannot be elastic or have speculation";
+        this->farm_policy_ = policy;
+    }
+
+    FarmStatistics farmStatistics() const final
+    {
+        FarmStatistics stats;
+        stats.workers = workers();
+        stats.max_workers = this->connections_.size();
+        stats.min_workers = elastic() ? std::min(minWorkers(), stats.max_workers) : stats.max_workers;
+        stats.rejected = rejected_.load(std::memory_order_relaxed);
+        stats.key_spilled = key_spilled_.load(std::memory_order_relaxed);
+        stats.scale_up = scale_up_.load(std::memory_order_relaxed);
+        stats.scale_down = scale_down_.load(std::memory_order_relaxed);
+        stats.last_scale = last_scale_.load(std::memory_order_relaxed);
+        stats.dispatched = dispatched_.load(std::memory_order_relaxed);
+        stats.speculated = speculated_.load(std::memory_order_relaxed);
+        if (this->farm_tracker_)
+        {
+            stats.duplicates = this->farm_tracker_->duplicates();
+            stats.latency_p50 = this->farm_tracker_->latency(0.5);
+            stats.latency_p99 = this->farm_tracker_->latency(0.99);
+        }
+        return stats;
+    }
+private:
+    bool elastic() const
+    {
+        return this->farm_policy_.max_workers > this->farm_policy_.min_workers;
+    }
+
+    unsigned int minWorkers() const
+    {
+        return std::max(this->farm_policy_.min_workers, 1u);
+    }
+    /*!
+     * \return The number of workers the items are dispatched to, the first ones of the connections.
+     */
+    unsigned int workers() const
+    {
         unsigned int size = this->connections_.size();
+        if (!elastic())
+            return size;
+        return std::min(active_.load(std::memory_order_relaxed), size);
+    }
+
+    std::shared_ptr<ConnectionT<T> > selectWorker(const T &data)
+    {
+        if (workers() == 0)
+            return nullptr;
+        switch (this->farm_policy_.dispatch)
+        {
+            case FarmPolicy::KEY_AFFINITY:
+                return selectByKey(FarmKey<T>::key(data));
+            case FarmPolicy::JOIN_SHORTEST_QUEUE:
+                return selectLeastLoaded(false);
+            case FarmPolicy::POWER_OF_TWO:
+                return selectPowerOfTwo();
+            case FarmPolicy::LEAST_EXPECTED_COMPLETION:
+                return selectLeastLoaded(true);
+            case FarmPolicy::WORK_QUEUE:
+                return hasRoom(this->connection(0)) ? this->connection(0) : nullptr;
+            default:
+                return selectIdle();
+        }
+    }
+    /*! \brief Write to a connection which is empty and whose task is idle, otherwise to the first
+     *  one with room in Round Robin order.
+     */
+    std::shared_ptr<ConnectionT<T> > selectIdle()
+    {
+        unsigned int size = workers();
+        rr_index_ %= size;
         for (unsigned int i = 0; i < size; ++i)
         {
             auto conn_ptr = this->connection(rr_index_);
-            if (!conn_ptr->hasNewData() && conn_ptr->input()->task()->state() == TaskState::IDLE)
+            if (conn_ptr->queueLength() == 0 && conn_ptr->input()->task()->state() == TaskState::IDLE)
             {
-                return conn_ptr->addData(data);
+                return conn_ptr;
             }
             rr_index_ = (rr_index_ + 1) % size;
         }
-        /* If there are no idle components iterate and find one that has at least the connection empty */
+        /* If there are no idle components iterate and find one that has at least room in the connection */
         for (unsigned int i = 0; i < size; ++i)
         {
             auto conn_ptr = this->connection(rr_index_);
-            if (!conn_ptr->hasNewData())
+            if (hasRoom(conn_ptr))
             {
-                return conn_ptr->addData(data);
+                return conn_ptr;
             }
             rr_index_ = (rr_index_ + 1) % size;
         }
-        /* In this case there are no idle components neither with an empty queue, so return false */
-        return false; // TODO decide what to do if there are no idle component
+        /* In this case all the queues are full, so return false */
+        return nullptr;
+    }
+    /*! \brief Select the worker with room that has the lowest load, or that would complete the item
+     *  first. The scan starts from a different worker every time to spread the ties.
+     *  \param expected_completion Weight the load with the time the worker needs for one item.
+     */
+    std::shared_ptr<ConnectionT<T> > selectLeastLoaded(bool expected_completion)
+    {
+        unsigned int size = workers();
+        std::shared_ptr<ConnectionT<T> > best;
+        unsigned int best_load = 0;
+        double best_time = 0;
+        for (unsigned int i = 0; i < size; ++i)
+        {
+            auto conn_ptr = this->connection((rr_index_ + i) % size);
+            if (!hasRoom(conn_ptr))
+                continue;
+            unsigned int worker_load = load(conn_ptr);
+            double time = expected_completion ? (worker_load + 1) * serviceTime(conn_ptr) : 0;
+            if (!best || time < best_time || (time == best_time && worker_load < best_load))
+            {
+                best = conn_ptr;
+                best_load = worker_load;
+                best_time = time;
+            }
+        }
+        if (size > 0)
+            rr_index_ = (rr_index_ + 1) % size;
+        return best;
+    }
+    /*! \brief Select the least loaded between two workers chosen at random.
+     *  If both queues are full all the workers are considered.
+     */
+    std::shared_ptr<ConnectionT<T> > selectPowerOfTwo()
+    {
+        unsigned int size = workers();
+        if (size < 2)
+            return selectLeastLoaded(false);
+        unsigned int first = random_() % size;
+        unsigned int second = (first + 1 + random_() % (size - 1)) % size;
+        auto first_ptr = this->connection(first);
+        auto second_ptr = this->connection(second);
+        bool first_room = hasRoom(first_ptr);
+        bool second_room = hasRoom(second_ptr);
+        if (first_room && (!second_room || load(first_ptr) <= load(second_ptr)))
+            return first_ptr;
+        if (second_room)
+            return second_ptr;
+        return selectLeastLoaded(false);
     }
 
-    bool write(const T &data, const std::string &task_name) final
+    /*! \brief Select the worker owning the key on a consistent hashing ring, so that the items with the
+     *  same key go to the same worker and only the keys of a worker move when it is activated or parked.
+     *  If the owner has no room or its load exceeds (1 + key_imbalance) times the mean, the next workers
+     *  along the ring are tried, as in consistent hashing with bounded loads.
+     */
+    std::shared_ptr<ConnectionT<T> > selectByKey(uint64_t key)
     {
-        COCO_ERR() << "Don't use this function with a farm component!";
-        return false;
+        unsigned int size = workers();
+        if (ring_workers_ != size)
+            buildRing(size);
+
+        unsigned int total_load = 0;
+        for (unsigned int i = 0; i < size; ++i)
+            total_load += load(this->connection(i));
+        double bound = std::ceil((1 + this->farm_policy_.key_imbalance) * (total_load + 1) / size);
+
+        auto it = std::lower_bound(ring_.begin(), ring_.end(), std::make_pair(mix(key), 0u));
+        if (it == ring_.end())
+            it = ring_.begin();
+        unsigned int owner = it->second;
+        for (unsigned int i = 0; i < ring_.size(); ++i)
+        {
+            auto conn_ptr = this->connection(it->second);
+            if (hasRoom(conn_ptr) && load(conn_ptr) < bound)
+            {
+                if (it->second != owner)
+                    key_spilled_.fetch_add(1, std::memory_order_relaxed);
+                return conn_ptr;
+            }
+            if (++it == ring_.end())
+                it = ring_.begin();
+        }
+        /* All the workers are above the bound, take any with room */
+        auto conn_ptr = selectLeastLoaded(false);
+        if (conn_ptr && conn_ptr != this->connection(owner))
+            key_spilled_.fetch_add(1, std::memory_order_relaxed);
+        return conn_ptr;
     }
-private:
+    /*! \brief Place each worker in many points of the ring to spread the keys evenly.
+     *  The points of a worker do not depend on the number of workers.
+     */
+    void buildRing(unsigned int size)
+    {
+        const unsigned int replicas = 64;
+        ring_.clear();
+        for (unsigned int worker = 0; worker < size; ++worker)
+            for (unsigned int replica = 0; replica < replicas; ++replica)
+                ring_.emplace_back(mix((static_cast<uint64_t>(worker) << 32) | replica), worker);
+        std::sort(ring_.begin(), ring_.end());
+        ring_workers_ = size;
+    }
+    /* Finalizer of splitmix64, spreads keys that are close to each other, as std::hash of integers is the identity */
+    static uint64_t mix(uint64_t x)
+    {
+        x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+        return x ^ (x >> 31);
+    }
+
+    bool hasRoom(const std::shared_ptr<ConnectionT<T> > &conn_ptr) const
+    {
+        return conn_ptr->queueLength() < static_cast<unsigned int>(std::max(conn_ptr->policy().buffer_size, 1));
+    }
+    /*!
+     * \return The number of items queued for the worker plus the one in execution.
+     */
+    unsigned int load(const std::shared_ptr<ConnectionT<T> > &conn_ptr) const
+    {
+        return conn_ptr->queueLength() + (conn_ptr->input()->task()->state() == TaskState::RUNNING ? 1 : 0);
+    }
+    /*!
+     * \return The mean execution time in seconds spent by the worker for each item read, 0 if unknown.
+     * The execution time is measured by the ExecutionEngine only with profiling enabled.
+     */
+    double serviceTime(const std::shared_ptr<ConnectionT<T> > &conn_ptr) const
+    {
+        uint64_t read = conn_ptr->statistics().read;
+        if (read == 0)
+            return 0;
+        return conn_ptr->input()->task()->timeStatistics().elapsed / read;
+    }
+    /*! \brief Select the worker and number the item, so that the gather can restore the dispatch order.
+     *  \param tag Where to store the FarmTag of the item.
+     */
+    std::shared_ptr<ConnectionT<T> > selectConnection(const T &data, FarmTag &tag)
+    {
+        if (elastic())
+            scale();
+        int long now = util::monotonicTime();
+        if (this->farm_tracker_)
+            speculate(now);
+        auto conn_ptr = selectWorker(data);
+        if (conn_ptr)
+        {
+            tag.sequence = ++sequence_;
+            tag.timestamp = now;
+            conn_ptr->setFarmTag(tag);
+            dispatched_.fetch_add(1, std::memory_order_relaxed);
+        }
+        else
+        {
+            rejected_.fetch_add(1, std::memory_order_relaxed);
+        }
+        return conn_ptr;
+    }
+    /*! \brief With speculation the item is dispatched as a shared sample, so that it is kept
+     *  without a copy until its result arrives and dispatched again without a copy.
+     */
+    bool dispatch(const std::shared_ptr<ConnectionT<T> > &conn_ptr, const FarmTag &tag,
+                  const std::shared_ptr<const T> &sample)
+    {
+        in_flight_.push_back({tag, conn_ptr.get(), false, sample});
+        return conn_ptr->addSample(sample);
+    }
+    /*! \brief Dispatch again to an idle worker the items without a result after FarmPolicy::speculation
+     *  times the median completion time, with the same FarmTag. Each item is dispatched again only once.
+     *  The items are checked at each dispatch, so the speculation is as frequent as the writes of the source.
+     */
+    void speculate(int long now)
+    {
+        const FarmTracker &tracker = *this->farm_tracker_;
+        while (!in_flight_.empty() && (tracker.completed(in_flight_.front().tag.sequence) ||
+                                       in_flight_.size() > FarmTracker::WINDOW / 2))
+            in_flight_.pop_front();
+
+        /* Wait for enough results to know the completion time */
+        uint64_t results = tracker.results();
+        if (results < 32)
+            return;
+        if (results >= median_results_ + 16)
+        {
+            median_ = tracker.latency(0.5);
+            median_results_ = results;
+        }
+        int long late = static_cast<int long>(this->farm_policy_.speculation * median_);
+        for (auto &item : in_flight_)
+        {
+            /* The items are in dispatch order, the following ones are not late either */
+            if (now - item.tag.timestamp < late)
+                break;
+            if (item.speculated || tracker.completed(item.tag.sequence))
+                continue;
+            auto conn_ptr = selectIdle(item.worker);
+            if (!conn_ptr)
+                break;
+            item.speculated = true;
+            conn_ptr->setFarmTag(item.tag);
+            if (conn_ptr->addSample(item.sample))
+                speculated_.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+    /*!
+     * \return An active worker with an empty queue that is not executing, other than the excluded one.
+     */
+    std::shared_ptr<ConnectionT<T> > selectIdle(const ConnectionT<T> *excluded)
+    {
+        for (unsigned int i = 0; i < workers(); ++i)
+        {
+            auto conn_ptr = this->connection(i);
+            if (conn_ptr.get() != excluded && conn_ptr->queueLength() == 0 &&
+                conn_ptr->input()->task()->state() == TaskState::IDLE)
+                return conn_ptr;
+        }
+        return nullptr;
+    }
+    /*! \brief Sample the load of the active workers at each dispatch and once every scale_interval
+     *  activate the first parked worker or park the last active one.
+     *  A worker is activated if items have been rejected or have been waiting in the queues,
+     *  it is parked if the remaining workers would be busy less than half of the time.
+     *  A parked worker completes the items in its queue and then waits for a trigger that never comes.
+     */
+    void scale()
+    {
+        auto now = util::monotonicTime();
+        unsigned int size = this->connections_.size();
+        unsigned int active = active_.load(std::memory_order_relaxed);
+        if (window_start_ == 0)
+        {
+            active = this->farm_policy_.workers > 0 ? this->farm_policy_.workers : minWorkers();
+            active = std::min(std::max(active, minWorkers()), size);
+            active_.store(active, std::memory_order_relaxed);
+            window_start_ = now;
+            window_rejected_ = rejected_.load(std::memory_order_relaxed);
+        }
+
+        for (unsigned int i = 0; i < active; ++i)
+        {
+            auto conn_ptr = this->connection(i);
+            window_queued_ += conn_ptr->queueLength();
+            window_load_ += load(conn_ptr);
+        }
+        ++window_samples_;
+        if (now - window_start_ < static_cast<int long>(this->farm_policy_.scale_interval) * 1000)
+            return;
+
+        uint64_t rejected = rejected_.load(std::memory_order_relaxed);
+        double queued = static_cast<double>(window_queued_) / window_samples_ / active;
+        double busy = static_cast<double>(window_load_) / window_samples_;
+        unsigned int max_workers = std::min(this->farm_policy_.max_workers, size);
+        if ((rejected > window_rejected_ || queued > 0.5) && active < max_workers)
+        {
+            active_.store(++active, std::memory_order_relaxed);
+            scale_up_.fetch_add(1, std::memory_order_relaxed);
+            last_scale_.store(now, std::memory_order_relaxed);
+            COCO_DEBUG("Farm") << "Activated worker " << active << " of " << max_workers;
+        }
+        else if (rejected == window_rejected_ && active > minWorkers() && busy / (active - 1) < 0.5)
+        {
+            active_.store(--active, std::memory_order_relaxed);
+            scale_down_.fetch_add(1, std::memory_order_relaxed);
+            last_scale_.store(now, std::memory_order_relaxed);
+            COCO_DEBUG("Farm") << "Parked worker " << active + 1 << " of " << max_workers;
+        }
+        window_start_ = now;
+        window_rejected_ = rejected;
+        window_queued_ = 0;
+        window_load_ = 0;
+        window_samples_ = 0;
+    }
+
     unsigned int rr_index_ = 0;
+    uint64_t sequence_ = 0;  // Sequence of the last item dispatched
+    std::minstd_rand random_;
+    std::vector<std::pair<uint64_t, unsigned int> > ring_;  // Consistent hashing ring of the KEY_AFFINITY dispatch
+    unsigned int ring_workers_ = 0;  // Number of workers in the ring
+
+    std::atomic<unsigned int> active_ = {0};  // Active workers of an elastic farm
+    std::atomic<uint64_t> rejected_ = {0};
+    std::atomic<uint64_t> key_spilled_ = {0};
+    std::atomic<uint64_t> dispatched_ = {0};
+    std::atomic<uint64_t> speculated_ = {0};
+    std::atomic<uint64_t> scale_up_ = {0};
+    std::atomic<uint64_t> scale_down_ = {0};
+    std::atomic<int long> last_scale_ = {0};
+    /* Items without a result yet, only with speculation */
+    struct InFlight
+    {
+        FarmTag tag;
+        const ConnectionT<T> *worker;
+        bool speculated;
+        std::shared_ptr<const T> sample;  // Shared with the connection of the worker
+    };
+    std::deque<InFlight> in_flight_;
+    int long median_ = 0;  // Median completion time in us
+    uint64_t median_results_ = 0;  // Results received when the median was computed
+    /* Load samples of the current scaling window */
+    int long window_start_ = 0;
+    uint64_t window_rejected_ = 0;
+    uint64_t window_queued_ = 0;
+    uint64_t window_load_ = 0;
+    unsigned int window_samples_ = 0;
 };
 
+/*! \brief Input connection manager where all the connections share a single lock free queue.
+ *  Reading is O(1) regardless of the number of connections and data is read in arrival order.
+ */
+template <class T>
+class ConnectionManagerInputFanIn : public ConnectionManagerInputT<T>
+{
+public:
+    /*! \brief Read the oldest data written by any of the connections.
+     *  The data read is accounted to the first connection, whose statistics refer to the shared queue.
+     *  \param data Variable where to store the read value
+     *  \return Wheter new data was present in the connections
+     */
+    FlowStatus read(T &data) final
+    {
+        if (this->connections_.empty())
+            return NO_DATA;
+        auto conn = this->connection(0);
+        if (conn->data(data) != NEW_DATA)
+            return NO_DATA;
+        conn->addRead();
+        return NEW_DATA;
+    }
+    /*! \brief Read the oldest data and its header. Sequence numbers are assigned by each writer
+     *  connection, so they are increasing only among the data of the same writer.
+     */
+    FlowStatus read(T &data, SampleInfo &info) final
+    {
+        if (this->connections_.empty())
+            return NO_DATA;
+        auto conn = this->connection(0);
+        if (conn->data(data, info) != NEW_DATA)
+            return NO_DATA;
+        conn->addRead();
+        return NEW_DATA;
+    }
+
+    FlowStatus read(std::shared_ptr<const T> &data) final
+    {
+        if (this->connections_.empty())
+            return NO_DATA;
+        auto conn = this->connection(0);
+        if (conn->sample(data) != NEW_DATA)
+            return NO_DATA;
+        conn->addRead();
+        return NEW_DATA;
+    }
+    /*! \brief Read all the data present in the queue, in arrival order.
+     *  \param data Vector where to store the data of all the connections.
+     *  \return Wheter new data was present in the connections
+     */
+    FlowStatus readAll(std::vector<T> &data) final
+    {
+        data.clear();
+        if (this->connections_.empty())
+            return NO_DATA;
+
+        T toutput;
+        auto conn = this->connection(0);
+        while (conn->data(toutput) == NEW_DATA)
+            data.push_back(std::move(toutput));
+        conn->addRead(data.size());
+        return data.empty() ? NO_DATA : NEW_DATA;
+    }
+
+    unsigned int readN(T *data, unsigned int n) final
+    {
+        if (this->connections_.empty())
+            return 0;
+        auto conn = this->connection(0);
+        unsigned int count = conn->dataN(data, n);
+        conn->addRead(count);
+        return count;
+    }
+    /*!
+     * \return The queue shared by all the connections of the port.
+     */
+    const std::shared_ptr<util::MPSCQueue<SampleSlot<T> > > & queue() const { return queue_; }
+    /*!
+     * \return The count of triggers added by the connections of the port and not yet removed.
+     */
+    const std::shared_ptr<std::atomic<unsigned int> > & triggered() const { return triggered_; }
+private:
+    std::shared_ptr<util::MPSCQueue<SampleSlot<T> > > queue_ =
+        std::make_shared<util::MPSCQueue<SampleSlot<T> > >();
+    std::shared_ptr<std::atomic<unsigned int> > triggered_ =
+        std::make_shared<std::atomic<unsigned int> >(0);
+};
 
 }  // end of namespace coco
@@ -13,8 +13,10 @@
 #include <atomic>
 #include <memory>
 #include <thread>
+#include <deque>
 #include <list>
 #include <mutex>
+#include <vector>
 #include <condition_variable>
 
 #include "coco/util/timing.h"
@@ -51,6 +53,14 @@ struct SchedulePolicy
         RR,
         DEADLINE
     };
+    /*! \brief What a periodic activity does when a step ends after the deadline of the next one
+     */
+    enum Overrun
+    {
+        CATCH_UP,    //!< Executes the missed periods back to back until it is on time again
+        SKIP_NEXT,   //!< Skips the missed periods, the next step is at the first deadline still ahead
+        PHASE_RESET  //!< Starts the next step immediately and the following periods from it
+    };
 
     /*! \brief Base constructor with default values.
      */
@@ -63,6 +73,7 @@ struct SchedulePolicy
     int affinity = -1;  //!< Specifies the core id where to pin the activity. If -1 no affinity
     int priority = 0;
     int runtime = 0;
+    Overrun overrun = CATCH_UP;  //!< Policy of a periodic activity missing a deadline
     std::list<unsigned int> available_core_id;  //!< Contains the list of the available cores where the activity can run
 };
 
@@ -91,8 +102,9 @@ public:
     virtual void trigger() = 0;
     /*! \brief Decreases the trigger count.
      *  When data from an event port is read decreases the trigger counter.
+     *  \return False if there was no pending trigger to remove.
      */
-    virtual void removeTrigger() = 0;
+    virtual bool removeTrigger() = 0;
     /*! \brief Main execution function.
      *  Contains the main execution loop. Manage the period timer in case of a periodic activity
      *  and the condition variable for trigger activityies.
@@ -139,18 +151,39 @@ public:
      * \return a global unique identifier for the activity
      */
     uint32_t id() const { return guid_; }
+    /*!
+     * \return The wakeup jitter and drift of a periodic activity.
+     */
+    util::PeriodTimer & periodTimer() { return period_timer_; }
 protected:
+    /*! \brief Decrease the number of pending triggers if greater than zero.
+     *  \return False if the number of pending triggers was already zero.
+     */
+    static bool decreaseTrigger(std::atomic<int> &pending_trigger);
+    /*! \brief Called by periodic activities after the steps started at deadline.
+     *  If the steps ended after the next deadline records the miss, notifies the runnables
+     *  and applies the \ref SchedulePolicy::Overrun policy. With CATCH_UP the late steps
+     *  that follow belong to the same overrun and are not counted again.
+     *  \return The time at which the next steps have to start.
+     */
+    std::chrono::steady_clock::time_point nextDeadline(std::chrono::steady_clock::time_point deadline);
+
     std::list<std::shared_ptr<RunnableInterface> > runnable_list_;
     SchedulePolicy policy_;
     bool active_;
     std::atomic<bool> stopping_;
+    util::PeriodTimer period_timer_;
+    /* CATCH_UP: the deadlines before this time were already late when the miss was recorded */
+    std::chrono::steady_clock::time_point catch_up_;
 
     static uint32_t guid_gen;
     const uint32_t  guid_;
 };
 
 /*! \brief Create an activity running on the main thread of the process.
- *  Maximum one sequential activity per application
+ *  Maximum one sequential activity per application.
+ *  On Linux the activity waits on an epoll loop: an eventfd signals triggers and stop requests,
+ *  a timerfd the deadlines of a periodic activity, so it uses no CPU while waiting.
  */
 class SequentialActivity: public Activity
 {
@@ -158,18 +191,17 @@ public:
     /*! \brief Specifies the execution policy when instantiating an activity
      */
     explicit SequentialActivity(SchedulePolicy policy);
+    ~SequentialActivity();
     /*! \brief Starts the activity.
      *  Simply call entry().
      */
     void start() final;
-
-    void stop() final;
-    /*! \brief NOT IMPLEMENTED FOR SEQUENTIAL ACTIVITY
+    /*! \brief Wakes up the loop, that terminates without waiting for the end of the period.
+     *  Async signal safe, can be called from a signal handler.
      */
+    void stop() final;
     void trigger() final;
-    /*! \brief NOT IMPLEMENTED FOR SEQUENTIAL ACTIVITY
-     */
-    void removeTrigger() final;
+    bool removeTrigger() final;
     /*! \brief Does nothing, nothing to join
      */
     void join() final;
@@ -177,6 +209,19 @@ public:
 protected:
 
     void entry() final;
+private:
+    /*! \brief Set the timer to expire at the absolute time deadline.
+     */
+    void armTimer(std::chrono::steady_clock::time_point deadline);
+    /*! \brief Wait for the timer, a trigger or a stop request.
+     *  \return True if the timer expired.
+     */
+    bool waitEvents();
+
+    std::atomic<int> pending_trigger_ = {0};
+    int epoll_fd_ = -1;
+    int event_fd_ = -1;  // Written by trigger() and stop()
+    int timer_fd_ = -1;  // Deadlines of a periodic activity
 };
 
 /*!
@@ -193,7 +238,7 @@ public:
     void start() final;
     void stop() final;
     void trigger() final;
-    void removeTrigger() final;
+    bool removeTrigger() final;
     void join() final;
     std::thread::id threadId() const final;
 protected:
@@ -206,6 +251,103 @@ protected:
     std::condition_variable cond_;
 };
 
+class PoolActivity;
+
+/*! \brief Fixed set of threads executing the steps of the \ref PoolActivity objects.
+ *  Each thread has its own deque of activities ready to run: an activity triggered by a pool thread
+ *  is pushed in the deque of that thread and executed next, close to the data it has just received.
+ *  A thread with an empty deque steals the oldest activity of the others, and sleeps if all of them are empty.
+ */
+class ThreadPool
+{
+public:
+    /*! \param threads Number of threads, if 0 one for each core.
+     *  \param pinned Wheter each thread is pinned to a core.
+     */
+    ThreadPool(unsigned int threads, bool pinned);
+    /*! \brief Stop and join the threads. The activities must have been stopped.
+     */
+    ~ThreadPool();
+    /*! \brief Start the threads, only the first call has effect.
+     *  \param cores The cores where the threads can run, the threads are pinned to them in Round Robin order.
+     */
+    void start(const std::list<unsigned int> &cores);
+    /*! \brief Make the activity ready to run. It must not be already queued.
+     *  \param activity The activity.
+     *  \param fair Put the activity after the ones already queued, used when it runs again.
+     */
+    void schedule(PoolActivity *activity, bool fair = false);
+    /*!
+     * \return The number of threads.
+     */
+    unsigned int size() const { return workers_.size(); }
+private:
+    struct Worker
+    {
+        std::mutex mutex;
+        std::deque<PoolActivity *> ready;
+        std::thread thread;
+    };
+
+    void entry(unsigned int index);
+    /*!
+     * \return The newest activity of the deque of the thread, or the oldest of another one. Null if all are empty.
+     */
+    PoolActivity * take(unsigned int index);
+
+    std::vector<std::unique_ptr<Worker> > workers_;
+    bool pinned_;
+    std::once_flag started_;
+    std::atomic<bool> stopping_ = {false};
+    std::atomic<unsigned int> queued_ = {0};    // Activities in the deques
+    std::atomic<unsigned int> sleeping_ = {0};  // Threads waiting on cond_
+    std::atomic<unsigned int> next_ = {0};      // Deque for the activities triggered by other threads
+    std::mutex mutex_;
+    std::condition_variable cond_;
+};
+
+/*! \brief Triggered activity without its own thread, whose steps are executed by a \ref ThreadPool.
+ *  Many activities can share few threads, the activity is never executed by two threads at the same time.
+ */
+class PoolActivity: public Activity
+{
+public:
+    /*! \param policy Must be SchedulePolicy::TRIGGERED.
+     *  \param pool The pool executing the activity.
+     */
+    PoolActivity(SchedulePolicy policy, std::shared_ptr<ThreadPool> pool);
+    /*! \brief Starts the pool, if needed, and schedules the initialization of the runnables.
+     */
+    void start() final;
+    void stop() final;
+    void trigger() final;
+    bool removeTrigger() final;
+    /*! \brief Wait for the pool to finalize the runnables after \ref stop().
+     */
+    void join() final;
+    /*!
+     * \return An empty id, the activity can be executed by any of the pool threads.
+     */
+    std::thread::id threadId() const final;
+    /*! \brief Executed by the pool: the first time it initializes the runnables, then it steps them
+     *  once if there are pending triggers and after \ref stop() it finalizes them.
+     *  The activity is scheduled again if it has still pending triggers.
+     */
+    void entry() final;
+private:
+    /*! \brief Schedule the activity if it is not already.
+     */
+    void wake();
+
+    std::shared_ptr<ThreadPool> pool_;
+    std::atomic<int> pending_trigger_ = {0};
+    std::atomic<bool> scheduled_ = {false};  // Queued in the pool or running
+    bool initialized_ = false;
+    bool finished_ = false;
+    std::mutex mutex_;
+    std::condition_variable cond_;
+};
+
 /*! \brief Interface that manages the execution of a component.
  *  It is in charge of the component initialization, loop function
  *  and pending operations.
@@ -222,6 +364,10 @@ public:
     /*! \brief It is called When the execution is stopped.
     */
     virtual void finalize() = 0;
+    /*! \brief Called by a periodic activity when the step ended after the deadline.
+     *  \param overrun Time in seconds by which the deadline was missed.
+     */
+    virtual void deadlineMiss(double overrun) {}
 protected:
 };
 
@@ -252,6 +398,9 @@ public:
     /*! Call the component stop function, TaskContext::stop().
      */
     void finalize() final;
+    /*! Call the component function TaskContext::onDeadlineMiss().
+     */
+    void deadlineMiss(double overrun) final;
     /*!
      * \return The pointer to the associated component object.
      */
@@ -0,0 +1,61 @@
+/**
+ * Project: CoCo
+ * Copyright (c) 2016, Scuola Superiore Sant'Anna
+ *
+ * Authors: Filippo Brizzi <fi.brizzi@sssup.it>, Emanuele Ruffaldi
+ * 
+ * This file is subject to the terms and conditions defined in
+ * file 'LICENSE.txt', which is part of this source code package.
+ */
+
+#pragma once
+
+#include <functional>
+
+#include "coco/task_impl.hpp"
+#include "coco/connection_impl.hpp"
+
+namespace coco
+{
+
+/*! \brief Node of the reduction tree that the loader builds between the workers and the gather of a farm.
+ *  At each execution it combines the results available from its inputs in a single partial result,
+ *  and writes it to the next level of the tree. The results of different inputs are interleaved,
+ *  so the combine function must be associative and commutative.
+ *  The reducer of a type is registered as a component with COCO_FARM_REDUCER.
+ */
+template <class T>
+class FarmReducer : public TaskContext
+{
+public:
+    /*! \brief Combine value in partial.
+     */
+    using CombineFx = std::function<void(T &partial, const T &value)>;
+
+    explicit FarmReducer(CombineFx combine)
+        : combine_(combine)
+    {}
+
+    InputPort<T> in_value_ = {this, "value_IN", true};
+    OutputPort<T> out_value_ = {this, "value_OUT"};
+
+    void init() {}
+    void onConfig() {}
+    /* Only the results already queued are combined, so that a fast producer cannot hold the partial */
+    void onUpdate()
+    {
+        unsigned int available = in_value_.queueLength();
+        if (available == 0 || in_value_.read(partial_) != NEW_DATA)
+            return;
+        for (unsigned int i = 1; i < available && in_value_.read(value_) == NEW_DATA; ++i)
+            combine_(partial_, value_);
+        out_value_.write(partial_);
+    }
+
+private:
+    CombineFx combine_;
+    T partial_;
+    T value_;
+};
+
+}  // end of namespace coco
@@ -54,6 +54,27 @@ struct TypeSpec
     TypeSpec(const char * name, const std::type_info & type,
              std::function<bool(std::ostream&, void*)>  out_fx);
 };
+/**
+ * Statistics of a connection identified by its end points.
+ * The task of a port living in another process is empty and its port is the IPC name of the connection.
+ */
+struct ConnectionTelemetry
+{
+    std::string src_task;
+    std::string src_port;
+    std::string dest_task;
+    std::string dest_port;
+    ConnectionStatistics statistics;
+};
+/**
+ * Statistics of the workers of a farm identified by the output port of its source.
+ */
+struct FarmTelemetry
+{
+    std::string src_task;
+    std::string src_port;
+    FarmStatistics statistics;
+};
 /**
  * Component Registry that is singleton per each exec or library. Then when the component library is loaded 
  * the singleton is replaced
@@ -99,6 +120,10 @@ public:
 
     static void setActivities(const std::vector<std::shared_ptr<Activity>> &activities);
     static const std::vector<std::shared_ptr<Activity>>& activities();
+    /// snapshot of the statistics of all the connections between the tasks
+    static std::vector<ConnectionTelemetry> connections();
+    /// snapshot of the workers and scaling events of all the farms
+    static std::vector<FarmTelemetry> farms();
 
 private:
     static ComponentRegistry & get();
@@ -114,6 +139,8 @@ private:
     TypeSpec *typeImpl(const std::type_info & ti);
     std::shared_ptr<TaskContext>  taskImpl(std::string name);
     void setActivitiesImpl(const std::vector<std::shared_ptr<Activity>> &activities);
+    std::vector<ConnectionTelemetry> connectionsImpl() const;
+    std::vector<FarmTelemetry> farmsImpl() const;
 
     bool profilingEnabledImpl();
     void enableProfilingImpl(bool enable);
@@ -179,6 +206,26 @@ private:
             return static_cast<bool>(ons); \
         });
 
+/// key of the items of type T for the farm KEY_AFFINITY dispatch, fx is called with a const T &
+#define COCO_FARM_KEY(T, fx) \
+    namespace coco { \
+    template <> \
+    struct FarmKey<T> \
+    { \
+        static const bool available = true; \
+        static uint64_t key(const T &data) { return farmKeyHash(fx(data)); } \
+    }; \
+    }
+
+/// registers the component name, a FarmReducer combining the results of type T with fx(T &partial, const T &value)
+#define COCO_FARM_REDUCER(T, fx, name) \
+    coco::ComponentSpec name##_spec = { #name, #name, [] () -> std::shared_ptr<coco::TaskContext> \
+        { \
+            std::shared_ptr<coco::TaskContext> task(new coco::FarmReducer<T>(fx)); \
+            task->setType<coco::FarmReducer<T> >(); \
+            return task; \
+        }};
+
 #define COCO_REGISTER(T) \
     coco::ComponentSpec T##_spec = { #T, #T, [] () -> std::shared_ptr<coco::TaskContext> \
         { \
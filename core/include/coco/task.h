@@ -15,11 +15,13 @@
 #include <mutex>
 #include <condition_variable>
 #include <atomic>
+#include <chrono>
 #include <unordered_map>
 #include <unordered_set>
 
 #include "coco/util/logging.h"
 #include "coco/util/timing.h"
+#include "coco/connection.h"
 
 namespace coco
 {
@@ -151,6 +153,7 @@ class ConnectionManager;
 enum class ConnectionManagerType;
 class ConnectionPolicy;
 class ConnectionBase;
+struct ConnectionStatistics;
 
 /*! \brief Base class to manage ports.
  *  Ports are used by components to exchange data.
@@ -201,10 +204,42 @@ public:
     unsigned int connectionsCount() const;
     /*!
       * \param connection The queue for the connection with the give id
-      *   if -1 the longest queue among all connection is returned.
+      *   if -1 the sum of the queues of all the connections is returned.
       * \return The lenght of the queue
       */
     unsigned int queueLength(int connection = -1) const;
+    /*!
+     * \param connection The connection id, if -1 the counters of all the connections are aggregated.
+     * \return The throughput and queue statistics of the connection, see ConnectionStatistics.
+     */
+    ConnectionStatistics statistics(int connection = -1) const;
+    /*!
+     * \param connection The connection id, if -1 the sum over all the connections.
+     * \return The number of data discarded because the connection buffer was full.
+     */
+    uint64_t droppedCount(int connection = -1) const;
+    /*!
+     * \param connection The connection id, if -1 the sum over all the connections.
+     * \return The time in microseconds writers have been blocked on full connection buffers.
+     */
+    uint64_t blockedTime(int connection = -1) const;
+    /*!
+     * \param connection The connection id, if -1 the maximum among all the connections.
+     * \return The maximum number of data that has been queued in the connection.
+     */
+    unsigned int highWaterMark(int connection = -1) const;
+    /*!
+     * \return The number of farm results received before an older one, only for the gather port of a farm.
+     */
+    uint64_t reorderedCount() const;
+    /*!
+     * \return The number of farm results discarded because too old, only for the gather port of a farm.
+     */
+    uint64_t discardedCount() const;
+    /*!
+     * \return The number of workers active and the scaling events, only for the source port of a farm.
+     */
+    FarmStatistics farmStatistics() const;
     /*!
      *  \return The type info of the port type.
      */
@@ -215,6 +250,12 @@ public:
      *  \return Wheter the connection was succesfully.
      */
     virtual bool connectTo(std::shared_ptr<PortBase> &other, ConnectionPolicy policy) = 0;
+    /*! \brief Connect the port to a port living in another process.
+     *  The other end of the connection is identified by ConnectionPolicy::name_id.
+     *  \param policy The policy of the connection, the transport must be ConnectionPolicy::IPC.
+     *  \return Wheter the connection was succesfully.
+     */
+    virtual bool connectToRemote(ConnectionPolicy policy) = 0;
     /*!
      * \return The shared pointer for the class
      */
@@ -225,15 +266,38 @@ public:
 protected:
     friend class ConnectionBase;
     friend class GraphLoader;
+    friend class ComponentRegistry;
+    template <class T>
+    friend class ConnectionManagerInputFarm;  // Triggers the gather for the results it buffers
+    friend class FarmAlarm;
 
     virtual void createConnectionManager(ConnectionManagerType type) = 0;
+    /*! \brief Called every time a connection is added to the port, so that the typed port
+     *  can select the direct access to its connection when it has only one.
+     */
+    virtual void connectionsChanged() {}
 
     /*! \brief Trigger the task owing this port to notify that new data is present in the port.
      */
     void triggerComponent();
     /*! \brief Once the data from the port has been read, remove the trigger from the task.
+     *  \return False if the task had no pending trigger.
+     */
+    bool removeTriggerComponent();
+    /*! \brief Notify that new data is present in the port, waking up the threads blocked in \ref waitData().
+     */
+    void notifyData();
+    /*!
+     *  \return Counter incremented by every \ref notifyData(). To be read before checking for new data
+     *  and passed to \ref waitData() so that no notification is lost.
      */
-    void removeTriggerComponent();
+    uint32_t dataSequence() const { return data_sequence_.load(); }
+    /*! \brief Block the calling thread until new data is notified or the deadline expires.
+     *  \param sequence The value returned by \ref dataSequence() before the last read.
+     *  \param deadline The absolute time until which to wait.
+     *  \return False if the deadline expired without notifications.
+     */
+    bool waitData(uint32_t sequence, const std::chrono::steady_clock::time_point &deadline);
     /*!
      *  \param Set the name of the port.
      */
@@ -254,6 +318,11 @@ protected:
     std::string doc_;
     bool is_output_;
     bool is_event_;
+
+    std::atomic<uint32_t> data_sequence_ = {0};
+    std::atomic<int> data_waiters_ = {0};
+    std::mutex wait_mutex_;
+    std::condition_variable wait_cond_;
 };
 
 // -------------------------------------------------------------------
@@ -530,6 +599,11 @@ public:
      * \return wheter the two tasks are executing on the same thread
      */
     bool isOnSameThread(const std::shared_ptr<TaskContext> &other) const;
+    /*!
+     * \param other A task of the same activity.
+     * \return Wheter at each step of the activity this task is executed before \p other.
+     */
+    bool runsBefore(const std::shared_ptr<TaskContext> &other) const;
 
     virtual uint32_t actvityId() const;
     /*!
@@ -578,10 +652,17 @@ protected:
      *  Called by the activity before terminationg. Can be used to safely release resources.
      */
     virtual void stop();
+    /*! \brief Can be override by the user in the derived class.
+     *  Called in the activity thread when a periodic activity finishes a step after the deadline
+     *  of the next one, before applying the overrun policy of the activity.
+     *  \param overrun Time in seconds by which the deadline was missed.
+     */
+    virtual void onDeadlineMiss(double overrun);
 
 private:
     friend class GraphLoader;
     friend class PortBase;
+    friend class ConnectionBase;
     // TODO resolve this abomination!
 //    template <class T>
 //    friend class ConnectionDataL;
@@ -606,8 +687,9 @@ private:
      */
     void triggerActivity(const std::string &port_name);
     /*! \brief When the data from a triggered input port is read, it decreases the trigger count from the owing activity.
+     *  \return False if the activity had no pending trigger.
      */
-    void removeTriggerActivity();
+    bool removeTriggerActivity();
     /*! \brief Pass to the task the pointer to the engine using managing the task.
      *  \param engine Shared pointer to the engine.
      */
@@ -642,6 +724,8 @@ private:
     bool wait_all_trigger_ = false;
     bool forward_check_ = true;
     std::mutex all_trigger_mutex_;
+
+    FarmTag farm_tag_;  // Farm item of the last data read, stamped on the data written. Accessed only by the task thread
 };
 
 /*!
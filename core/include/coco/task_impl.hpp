@@ -10,6 +10,7 @@
 
 #pragma once
 
+#include <atomic>
 #include <boost/lexical_cast.hpp>
 #include "coco/util/accesses.hpp"
 #include "coco/connection.h"
@@ -226,6 +227,12 @@ class ConnectionManagerInputFarm;
 template <class T>
 class ConnectionManagerOutputFarm;
 template <class T>
+class ConnectionManagerInputFanIn;
+template <class T>
+struct MakeConnection;
+template <class T>
+struct WorkQueue;
+template <class T>
 class ConnectionT;
 template <class T>
 class OutputPort;
@@ -281,14 +288,120 @@ public:
         }
         return true;
     }
+    /*!
+     * \brief Connect the port to an OutputPort living in another process.
+     * \param policy The policy of the connection, must have IPC transport
+     * \return Wheter the connection has been successfully
+     */
+    bool connectToRemote(ConnectionPolicy policy) final
+    {
+        if (policy.transport != ConnectionPolicy::IPC)
+        {
+            COCO_ERR() << "Port " << this->name() << " can be connected to another process only with IPC transport";
+            return false;
+        }
+        std::shared_ptr<OutputPort<T> > remote;
+        std::shared_ptr<ConnectionBase> connection(
+                makeConnection(
+                    std::static_pointer_cast<InputPort<T> >(this->sharedPtr()),
+                    remote, policy));
+        if (!connection)
+            return false;
+        addConnection(connection);
+        return true;
+    }
     /*! \brief Using a round robin schedule polls all its connections to see if someone has new data to be read
      *	\param output The variable where to store the result. If no new data is available the value of \ref output is not changed.
      *  \return The read result, wheter new data is present
      */
     FlowStatus read(T &data)
     {
+        if (single_)
+        {
+            if (single_->data(data) != NEW_DATA)
+                return NO_DATA;
+            single_->addRead();
+            return NEW_DATA;
+        }
+        assert(this->manager_ && "Before reading a port, instantiate the ConnectionManager");
+        return manager()->read(data);
+    }
+    /*! \brief Same as \ref read(T &) but also returns the header written with the data.
+     *  \code
+     *  if (in_.read(value, info) == NEW_DATA)
+     *      latency = util::monotonicTime() - info.timestamp;
+     *  \endcode
+     *  \param data The variable where to store the data.
+     *  \param info The monotonic write timestamp and the sequence number of the data in its connection.
+     *  A jump in the sequence number means that samples have been lost, for example overwritten
+     *  in a \ref ConnectionPolicy::CIRCULAR connection.
+     *  \return The read result, wheter new data is present
+     */
+    FlowStatus read(T &data, SampleInfo &info)
+    {
+        if (single_)
+        {
+            if (single_->data(data, info) != NEW_DATA)
+                return NO_DATA;
+            single_->addRead();
+            return NEW_DATA;
+        }
         assert(this->manager_ && "Before reading a port, instantiate the ConnectionManager");
-        return std::static_pointer_cast<ConnectionManagerInputT<T> >(this->manager_)->read(data);
+        return manager()->read(data, info);
+    }
+    /*! \brief Same as \ref read(T &) but the data is not copied when it was published
+     *  with OutputPort::publish() or through a broadcast connection, the reader gets a read-only
+     *  reference to the sample shared with the writer and the other readers.
+     *  The sample remains valid as long as \p data holds it.
+     *  \param data The shared pointer where to store the sample.
+     *  \return The read result, wheter new data is present
+     */
+    FlowStatus read(std::shared_ptr<const T> &data)
+    {
+        if (single_)
+        {
+            if (single_->sample(data) != NEW_DATA)
+                return NO_DATA;
+            single_->addRead();
+            return NEW_DATA;
+        }
+        assert(this->manager_ && "Before reading a port, instantiate the ConnectionManager");
+        return manager()->read(data);
+    }
+
+    /*! \brief Same as \ref read(T &) but if no data is present blocks the calling thread until
+     *  data is written in one of the connections or \p timeout expires.
+     *  The thread is parked, so a periodic task can wait for a port inside onUpdate() without spinning.
+     *  \param data The variable where to store the result.
+     *  \param timeout Maximum time to wait.
+     *  \return NEW_DATA if data was read before the timeout, NO_DATA otherwise.
+     */
+    template <class Rep, class Period>
+    FlowStatus read(T &data, const std::chrono::duration<Rep, Period> &timeout)
+    {
+        return readUntil(data, std::chrono::steady_clock::now() + timeout);
+    }
+    /*! \brief Same as \ref read(T &, const std::chrono::duration<Rep, Period> &) for samples.
+     */
+    template <class Rep, class Period>
+    FlowStatus read(std::shared_ptr<const T> &data, const std::chrono::duration<Rep, Period> &timeout)
+    {
+        return readUntil(data, std::chrono::steady_clock::now() + timeout);
+    }
+    /*! \brief Same as \ref read(T &, const std::chrono::duration<Rep, Period> &) with an absolute deadline.
+     *  \param data The variable where to store the result.
+     *  \param deadline Time point until which to wait.
+     *  \return NEW_DATA if data was read before the deadline, NO_DATA otherwise.
+     */
+    FlowStatus readUntil(T &data, const std::chrono::steady_clock::time_point &deadline)
+    {
+        return waitRead(data, deadline);
+    }
+    /*! \brief Same as \ref readUntil(T &, const std::chrono::steady_clock::time_point &) for samples.
+     */
+    FlowStatus readUntil(std::shared_ptr<const T> &data, const std::chrono::steady_clock::time_point &deadline)
+    {
+        return waitRead(data, deadline);
     }
 
     /*! \brief It polls all the connections and read all the data at the same time, storing the result in a vector.
@@ -300,7 +413,19 @@ public:
     FlowStatus readAll(std::vector<T> &data)
     {
         assert(this->manager_ && "Before reading a port, instantiate the ConnectionManager");
-        return std::static_pointer_cast<ConnectionManagerInputT<T> >(this->manager_)->readAll(data);
+        return manager()->readAll(data);
+    }
+    /*! \brief Read up to \p n data in a caller provided array, without allocating memory.
+     *  Each connection is accessed once, the task is untriggered once for each data read
+     *  as with \ref read(), so batch and single reads and writes can be mixed.
+     *  \param data Array of at least \p n elements where to store the data.
+     *  \param n The maximum number of data to read.
+     *  \return The number of data read.
+     */
+    unsigned int readN(T *data, unsigned int n)
+    {
+        assert(this->manager_ && "Before reading a port, instantiate the ConnectionManager");
+        return manager()->readN(data, n);
     }
     /*!
      * \return True if the port has incoming new data;
@@ -310,6 +435,46 @@ private:
     friend class OutputPort<T>;
     friend class GraphLoader;
 
+    /*!
+     * \return The typed connection manager, without touching the reference count of \ref manager_.
+     */
+    ConnectionManagerInputT<T> *manager() const
+    {
+        return static_cast<ConnectionManagerInputT<T> *>(this->manager_.get());
+    }
+    /*! \brief Select the direct access to the connection when the port has a single connection
+     *  managed by the default manager, all the reads then skip the manager.
+     */
+    void connectionsChanged() final
+    {
+        single_ = nullptr;
+        if (manager_type_ == ConnectionManagerType::DEFAULT && manager()->connectionsCount() == 1)
+            single_ = manager()->connection(0).get();
+    }
+
+    template <class D>
+    FlowStatus waitRead(D &data, const std::chrono::steady_clock::time_point &deadline)
+    {
+        while (true)
+        {
+            /* Take the sequence before reading, data written after the read changes it */
+            uint32_t sequence = this->dataSequence();
+            if (read(data) == NEW_DATA)
+                return NEW_DATA;
+            if (!this->waitData(sequence, deadline))
+                return NO_DATA;
+        }
+    }
+    friend struct MakeConnection<T>;
+
+    /*!
+     * \return The connection manager if it is of type ConnectionManagerType::FAN_IN, null otherwise.
+     */
+    std::shared_ptr<ConnectionManagerInputFanIn<T> > fanInManager() const
+    {
+        return std::dynamic_pointer_cast<ConnectionManagerInputFanIn<T> >(this->manager_);
+    }
+
     /*! \brief Called by \ref connectTo(), does the actual connection once the type have been checked.
      *  \param other The other port to which to connect.
      *  \param policy The connection policy.
@@ -344,8 +509,16 @@ private:
             case ConnectionManagerType::FARM:
                 this->manager_ = std::make_shared<ConnectionManagerInputFarm<T> >();
                 break;
+            case ConnectionManagerType::FAN_IN:
+                this->manager_ = std::make_shared<ConnectionManagerInputFanIn<T> >();
+                break;
         }
+        manager_type_ = type;
+        connectionsChanged();
     }
+
+    ConnectionManagerType manager_type_ = ConnectionManagerType::DEFAULT;
+    ConnectionT<T> *single_ = nullptr;  //!< The only connection of the port, owned by \ref manager_. Null if the manager has to be used.
 };
 
 /*! \brief Class representing an output port containing data of type T
@@ -390,12 +563,47 @@ public:
         }
         return true;
     }
+    /*!
+     * \brief Connect the port to an InputPort living in another process.
+     * \param policy The policy of the connection, must have IPC transport
+     * \return Wheter the connection has been successfully
+     */
+    bool connectToRemote(ConnectionPolicy policy) final
+    {
+        if (policy.transport != ConnectionPolicy::IPC)
+        {
+            COCO_ERR() << "Port " << this->name() << " can be connected to another process only with IPC transport";
+            return false;
+        }
+        std::shared_ptr<InputPort<T> > remote;
+        std::shared_ptr<ConnectionBase> connection(
+                makeConnection(
+                    remote,
+                    std::static_pointer_cast<OutputPort<T> >(this->sharedPtr()),
+                    policy));
+        if (!connection)
+            return false;
+        addConnection(connection);
+        return true;
+    }
     /*! \brief Write in each connection associated with this port.
      *  \param input The value to be written in each output connection.
      */
     bool write(const T &data)
     {
-        return std::static_pointer_cast<ConnectionManagerOutputT<T> >(manager_)->write(data);
+        if (single_)
+            return single_->addData(data);
+        return manager()->write(data);
+    }
+    /*! \brief Same as \ref write(const T &) but avoids one copy, the last connection takes
+     *  the ownership of \p data.
+     *  \param input The value to be written in each output connection.
+     */
+    bool write(T &&data)
+    {
+        if (single_)
+            return single_->addData(std::move(data));
+        return manager()->write(std::move(data));
     }
     /*! \brief Write only in a specific port contained in the task named \ref name.
      *  \param input The value to be written.
@@ -403,12 +611,85 @@ public:
      */
     bool write(const T &data, const std::string &task_name)
     {
-        return std::static_pointer_cast<ConnectionManagerOutputT<T> >(manager_)->write(data, task_name);
+        return manager()->write(data, task_name);
+    }
+    /*! \brief Write \p n values in each connection associated with this port.
+     *  Each connection is accessed once and the reader is triggered once for each value,
+     *  as with \ref write(), so batch and single reads and writes can be mixed.
+     *  \param data Array of \p n elements to be written.
+     *  \param n The number of elements to be written.
+     */
+    bool writeBatch(const T *data, unsigned int n)
+    {
+        return manager()->writeBatch(data, n);
+    }
+    /*! \brief Same as \ref writeBatch(const T *, unsigned int) for all the elements of \p data.
+     */
+    bool writeBatch(const std::vector<T> &data)
+    {
+        return writeBatch(data.data(), data.size());
+    }
+    /*! \brief Loan a sample to be filled and then sent with \ref publish().
+     *  Samples are recycled once all the readers have released them, so the content
+     *  of the returned sample is the one of an old publication and should be overwritten.
+     *  \return A sample owned by the port.
+     */
+    std::shared_ptr<T> loan()
+    {
+        for (auto &sample : loan_pool_)
+        {
+            if (sample.use_count() == 1)
+            {
+                /* Synchronize with the readers that released the sample */
+                std::atomic_thread_fence(std::memory_order_acquire);
+                return sample;
+            }
+        }
+        loan_pool_.push_back(std::make_shared<T>());
+        return loan_pool_.back();
+    }
+    /*! \brief Share a sample obtained with \ref loan() with all the connections without copying it.
+     *  Readers using InputPort::read(std::shared_ptr<const T> &) get a reference to the sample,
+     *  the others get a copy. Connections with IPC transport always copy it.
+     *  \param sample The sample, it is reset so that the writer cannot modify it any more.
+     *  \return Wheter the write succeded
+     */
+    bool publish(std::shared_ptr<T> &sample)
+    {
+        std::shared_ptr<const T> data(std::move(sample));
+        return manager()->publish(data);
     }
 
 private:
     friend class InputPort<T>;
     friend class GraphLoader;
+    friend struct MakeConnection<T>;
+
+    std::vector<std::shared_ptr<T> > loan_pool_;
+    std::shared_ptr<WorkQueue<T> > work_queue_;  //!< Shared by the ConnectionPolicy::WORK_QUEUE connections of the port, created by the first one.
+    ConnectionManagerType manager_type_ = ConnectionManagerType::DEFAULT;
+    ConnectionT<T> *single_ = nullptr;  //!< The only connection of the port, owned by \ref manager_. Null if the manager has to be used.
+
+    /*!
+     * \return The typed connection manager, without touching the reference count of \ref manager_.
+     */
+    ConnectionManagerOutputT<T> *manager() const
+    {
+        return static_cast<ConnectionManagerOutputT<T> *>(this->manager_.get());
+    }
+    /*! \brief Select the direct access to the connection when the port has a single connection
+     *  managed by the default manager and it is not a broadcast one, writes then skip the manager.
+     */
+    void connectionsChanged() final
+    {
+        single_ = nullptr;
+        if (manager_type_ == ConnectionManagerType::DEFAULT && manager()->connectionsCount() == 1)
+        {
+            auto connection = manager()->connection(0);
+            if (!connection->policy().broadcast)
+                single_ = connection.get();
+        }
+    }
 
     /*! \brief Called by \ref connectTo(), does the actual connection once the type have been checked.
      *  \param other The other port to which to connect.
@@ -445,6 +726,8 @@ private:
                 COCO_FATAL() << "Invalid ConnectionManagerType " << static_cast<int>(type);
                 break;
         }
+        manager_type_ = type;
+        connectionsChanged();
     }
 };
 
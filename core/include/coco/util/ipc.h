@@ -0,0 +1,113 @@
+/**
+ * Project: CoCo
+ * Copyright (c) 2016, Scuola Superiore Sant'Anna
+ *
+ * Authors: Filippo Brizzi <fi.brizzi@sssup.it>, Emanuele Ruffaldi
+ *
+ * This file is subject to the terms and conditions defined in
+ * file 'LICENSE.txt', which is part of this source code package.
+ */
+
+#pragma once
+#include <atomic>
+#include <string>
+#include <cstdint>
+#include <cstddef>
+
+namespace coco
+{
+namespace util
+{
+
+/*! \brief Ring buffer of fixed size elements living in a POSIX shared memory segment.
+ *  The segment is identified by its name, so two processes opening a ring with the same
+ *  name share the same storage. The first process opening the segment initializes it,
+ *  the others only attach to it. The segment records the processes using it and the last
+ *  one to close the ring removes its name.
+ *  A segment whose initializer died or hangs is initialized again, as is a segment whose
+ *  processes are all dead. The mutex is robust, if a process dies holding it the content
+ *  of the ring is discarded.
+ *  Elements are copied byte by byte, so only trivially copyable types can be stored.
+ *  Every push increases a sequence counter, used as futex word to wake up the
+ *  processes waiting for new data. The futex is woken only if a process is waiting.
+ */
+class SharedMemoryRing
+{
+public:
+    /*!
+     * \param name Name of the shared memory segment, must start with '/'.
+     * \param capacity Maximum number of elements in the ring.
+     * \param element_size Size in bytes of a single element.
+     * \param overwrite If true when the ring is full the oldest element is overwritten,
+     *        otherwise the new element is discarded.
+     */
+    SharedMemoryRing(const std::string &name, unsigned int capacity,
+                     size_t element_size, bool overwrite);
+    ~SharedMemoryRing();
+    /*!
+     * \return Wheter the segment has been successfully opened and mapped.
+     */
+    bool isValid() const { return header_ != nullptr; }
+    /*! \brief Copy an element in the ring and wake up the waiting readers.
+     *  \param element Pointer to \ref element_size bytes to be copied.
+     *  \return False if the ring is full and the overwrite policy is not set.
+     */
+    bool push(const void *element);
+    /*! \brief Copy the oldest element of the ring in \p element and remove it.
+     *  \return False if the ring is empty.
+     */
+    bool pop(void *element);
+    /*! \brief Copy \p n contiguous elements in the ring with a single lock and a single wake up.
+     *  \return The number of elements copied.
+     */
+    unsigned int push(const void *elements, unsigned int n);
+    /*! \brief Copy up to \p n of the oldest elements in the contiguous array \p elements.
+     *  \return The number of elements copied.
+     */
+    unsigned int pop(void *elements, unsigned int n);
+    /*! \brief Copy the newest element of the ring in \p element and empty the ring.
+     *  \return False if the ring is empty.
+     */
+    bool popNewest(void *element);
+    /*!
+     * \return The number of elements currently in the ring.
+     */
+    unsigned int size() const;
+    /*!
+     * \return The current value of the push sequence counter.
+     */
+    uint32_t sequence() const;
+    /*! \brief Block the calling thread until the sequence counter is different from \p sequence,
+     *  a wakeAll() is issued or the timeout expires.
+     *  \param sequence The last value of the sequence counter seen by the caller.
+     *  \param timeout_ms Maximum waiting time in milliseconds.
+     *  \return The current value of the sequence counter.
+     */
+    uint32_t wait(uint32_t sequence, int timeout_ms) const;
+    /*! \brief Wake up all the threads, of any process, waiting on the ring.
+     */
+    void wakeAll() const;
+
+private:
+    struct Header;
+    class Lock;
+
+    static size_t headerSize();
+    bool map(size_t size);
+    void unmap();
+    /*! \brief Initialize the segment or wait for another process to do it, then register the process.
+     *  \return False if the segment must be mapped again because it has just been removed.
+     */
+    bool attach(unsigned int capacity, size_t element_size);
+    void initialize(unsigned int capacity, size_t element_size);
+    char *slot(uint64_t index) const;
+
+    std::string name_;
+    size_t size_ = 0;
+    bool overwrite_;
+    Header *header_ = nullptr;
+    char *data_ = nullptr;
+};
+
+}  // end of namespace util
+}  // end of namespace coco
@@ -0,0 +1,132 @@
+/**
+ * Project: CoCo
+ * Copyright (c) 2016, Scuola Superiore Sant'Anna
+ *
+ * Authors: Filippo Brizzi <fi.brizzi@sssup.it>, Emanuele Ruffaldi
+ *
+ * This file is subject to the terms and conditions defined in
+ * file 'LICENSE.txt', which is part of this source code package.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <vector>
+#include <cstddef>
+#include <utility>
+
+namespace coco
+{
+namespace util
+{
+
+/*! \brief Bounded lock-free queue for multiple producers and multiple consumers.
+ *  Same cells as MPSCQueue (D. Vyukov bounded queue), but also the consumers
+ *  reserve a position with a CAS, so each element is removed by exactly one of them.
+ */
+template <class T>
+class MPMCQueue
+{
+public:
+    /*! \param capacity The maximum number of elements, rounded to a power of two.
+     */
+    explicit MPMCQueue(size_t capacity)
+    {
+        size_t size = 1;
+        while (size < capacity)
+            size <<= 1;
+        cells_ = std::vector<Cell>(size);
+        for (size_t i = 0; i < size; ++i)
+            cells_[i].sequence.store(i, std::memory_order_relaxed);
+        mask_ = size - 1;
+    }
+    /*! \brief Add an element to the queue. Can be called concurrently by multiple threads.
+     *  \return False if the queue is full.
+     */
+    template <class U>
+    bool push(U &&value)
+    {
+        Cell *cell;
+        size_t pos = tail_.load(std::memory_order_relaxed);
+        while (true)
+        {
+            cell = &cells_[pos & mask_];
+            size_t sequence = cell->sequence.load(std::memory_order_acquire);
+            auto diff = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(pos);
+            if (diff == 0)
+            {
+                if (tail_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                    break;
+            }
+            else if (diff < 0)
+            {
+                return false;
+            }
+            else
+            {
+                pos = tail_.load(std::memory_order_relaxed);
+            }
+        }
+        cell->value = std::forward<U>(value);
+        cell->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+    /*! \brief Remove the oldest element from the queue. Can be called concurrently by multiple threads.
+     *  \return False if the queue is empty.
+     */
+    bool pop(T &value)
+    {
+        Cell *cell;
+        size_t pos = head_.load(std::memory_order_relaxed);
+        while (true)
+        {
+            cell = &cells_[pos & mask_];
+            size_t sequence = cell->sequence.load(std::memory_order_acquire);
+            auto diff = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(pos + 1);
+            if (diff == 0)
+            {
+                if (head_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                    break;
+            }
+            else if (diff < 0)
+            {
+                return false;
+            }
+            else
+            {
+                pos = head_.load(std::memory_order_relaxed);
+            }
+        }
+        value = std::move(cell->value);
+        cell->sequence.store(pos + mask_ + 1, std::memory_order_release);
+        return true;
+    }
+    /*!
+     * \return The number of elements in the queue, approximated if producers or consumers are active.
+     */
+    size_t size() const
+    {
+        size_t head = head_.load(std::memory_order_relaxed);
+        size_t tail = tail_.load(std::memory_order_relaxed);
+        return tail > head ? tail - head : 0;
+    }
+    /*!
+     * \return The maximum number of elements.
+     */
+    size_t capacity() const { return mask_ + 1; }
+
+private:
+    struct Cell
+    {
+        std::atomic<size_t> sequence;
+        T value;
+    };
+
+    std::vector<Cell> cells_;
+    size_t mask_ = 0;
+    std::atomic<size_t> head_ = {0};
+    std::atomic<size_t> tail_ = {0};
+};
+
+}  // end of namespace util
+}  // end of namespace coco
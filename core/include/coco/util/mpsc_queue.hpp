@@ -0,0 +1,119 @@
+/**
+ * Project: CoCo
+ * Copyright (c) 2016, Scuola Superiore Sant'Anna
+ *
+ * Authors: Filippo Brizzi <fi.brizzi@sssup.it>, Emanuele Ruffaldi
+ *
+ * This file is subject to the terms and conditions defined in
+ * file 'LICENSE.txt', which is part of this source code package.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <vector>
+#include <cstddef>
+#include <utility>
+
+namespace coco
+{
+namespace util
+{
+
+/*! \brief Bounded lock-free queue for multiple producers and a single consumer.
+ *  Each cell has a sequence number telling whether it is free for the producer
+ *  of a given position or ready for the consumer (D. Vyukov bounded queue).
+ *  Producers reserve a position with a CAS, the consumer never waits on them.
+ */
+template <class T>
+class MPSCQueue
+{
+public:
+    /*! \brief Increase the capacity of the queue, rounded to a power of two.
+     *  Not thread safe, it must be called before producers and consumer start.
+     *  \param capacity The number of elements to add to the capacity.
+     */
+    void addCapacity(size_t capacity)
+    {
+        capacity_ += capacity;
+        size_t size = 1;
+        while (size < capacity_)
+            size <<= 1;
+        cells_ = std::vector<Cell>(size);
+        for (size_t i = 0; i < size; ++i)
+            cells_[i].sequence.store(i, std::memory_order_relaxed);
+        mask_ = size - 1;
+        head_.store(0, std::memory_order_relaxed);
+        tail_.store(0, std::memory_order_relaxed);
+    }
+    /*! \brief Add an element to the queue. Can be called concurrently by multiple threads.
+     *  \return False if the queue is full.
+     */
+    template <class U>
+    bool push(U &&value)
+    {
+        Cell *cell;
+        size_t pos = tail_.load(std::memory_order_relaxed);
+        while (true)
+        {
+            cell = &cells_[pos & mask_];
+            size_t sequence = cell->sequence.load(std::memory_order_acquire);
+            auto diff = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(pos);
+            if (diff == 0)
+            {
+                if (tail_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                    break;
+            }
+            else if (diff < 0)
+            {
+                return false;
+            }
+            else
+            {
+                pos = tail_.load(std::memory_order_relaxed);
+            }
+        }
+        cell->value = std::forward<U>(value);
+        cell->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+    /*! \brief Remove the oldest element from the queue. Only one thread can call it.
+     *  \return False if the queue is empty.
+     */
+    bool pop(T &value)
+    {
+        size_t pos = head_.load(std::memory_order_relaxed);
+        Cell &cell = cells_[pos & mask_];
+        if (cell.sequence.load(std::memory_order_acquire) != pos + 1)
+            return false;
+        value = std::move(cell.value);
+        cell.sequence.store(pos + mask_ + 1, std::memory_order_release);
+        head_.store(pos + 1, std::memory_order_relaxed);
+        return true;
+    }
+    /*!
+     * \return The number of elements in the queue, approximated if producers are pushing.
+     */
+    size_t size() const
+    {
+        size_t head = head_.load(std::memory_order_relaxed);
+        size_t tail = tail_.load(std::memory_order_relaxed);
+        return tail > head ? tail - head : 0;
+    }
+
+private:
+    struct Cell
+    {
+        std::atomic<size_t> sequence;
+        T value;
+    };
+
+    std::vector<Cell> cells_;
+    size_t mask_ = 0;
+    size_t capacity_ = 0;
+    std::atomic<size_t> head_ = {0};
+    std::atomic<size_t> tail_ = {0};
+};
+
+}  // end of namespace util
+}  // end of namespace coco
@@ -44,6 +44,15 @@ inline int long time()
             std::chrono::system_clock::now().time_since_epoch()).count();
 }
 
+/*! \brief Monotonic time in microseconds, not affected by changes of the system clock.
+ *  Only differences between two values are meaningful, and only inside the same machine.
+ */
+inline int long monotonicTime()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
 struct TimeStatistics
 {
     unsigned long iterations;
@@ -55,6 +64,14 @@ struct TimeStatistics
     double service_variance;
     double min;
     double max;
+    /* Periodic activity executing the task, 0 if triggered */
+    double jitter_mean = 0;  // Mean delay of the wakeups from their deadline
+    double jitter_max = 0;   // Maximum delay of the wakeups from their deadline
+    double drift = 0;        // Offset of the last wakeup from its scheduled deadline
+    bool periodic = false;   // The jitter and drift fields are valid
+    unsigned long deadline_misses = 0;  // Steps ended after the deadline of the next one
+    double overrun_max = 0;             // Maximum time by which a step missed the deadline
+    std::vector<unsigned long> overrun_histogram;  // Misses by overrun, buckets in PeriodTimer::miss()
 
     std::string toString() const
     {
@@ -67,6 +84,21 @@ struct TimeStatistics
         ss << "\tService time variance: " << service_variance << std::endl;
         ss << "\tMin: " << min << std::endl; 
         ss << "\tMax: " << max << std::endl;
+        if (periodic)
+        {
+            ss << "\tJitter mean: " << jitter_mean << std::endl;
+            ss << "\tJitter max : " << jitter_max << std::endl;
+            ss << "\tDrift      : " << drift << std::endl;
+        }
+        if (deadline_misses > 0)
+        {
+            ss << "\tDeadline misses: " << deadline_misses << std::endl;
+            ss << "\tOverrun max    : " << overrun_max << std::endl;
+            ss << "\tOverrun histogram:";
+            for (auto count : overrun_histogram)
+                ss << " " << count;
+            ss << std::endl;
+        }
         return ss.str();
     }
 };
@@ -190,6 +222,103 @@ private:
     std::atomic<bool> lock_ = {false};
 };
 
+/*! \brief Wakeup statistics of a periodic activity, in seconds like \ref Timer.
+ *  The jitter is the delay of each wakeup from its deadline, the drift the signed offset
+ *  of the last wakeup from its scheduled deadline. The deadlines already account for the
+ *  periods skipped or reset by the overrun policy, so these do not show up as drift.
+ */
+class PeriodTimer
+{
+public:
+    using time_point = std::chrono::steady_clock::time_point;
+    static constexpr unsigned int OVERRUN_BUCKETS_COUNT = 5;
+
+    /*! \brief Record a wakeup.
+     *  \param deadline The time at which the activity should have woken up.
+     *  \param now The time at which it woke up.
+     */
+    void wakeup(time_point deadline, time_point now)
+    {
+        while (lock_.exchange(true));
+
+        drift_ = std::chrono::duration_cast<std::chrono::microseconds>(
+                 now - deadline).count() / 1000000.0;
+        double jitter = std::max(drift_, 0.0);
+        jitter_ += jitter;
+        jitter_max_ = std::max(jitter, jitter_max_);
+        ++iterations_;
+
+        lock_ = false;
+    }
+    /*! \brief Record a step that ended after the deadline of the next one.
+     *  \param overrun The time by which the deadline was missed.
+     *  \param period The period of the activity.
+     */
+    void miss(std::chrono::nanoseconds overrun, std::chrono::nanoseconds period)
+    {
+        while (lock_.exchange(true));
+
+        /* Upper bounds of the histogram buckets as fractions of the period, the last bucket is unbounded */
+        static const double bounds[OVERRUN_BUCKETS_COUNT - 1] = {0.1, 0.5, 1, 2};
+        double ratio = static_cast<double>(overrun.count()) / period.count();
+        unsigned int bucket = 0;
+        while (bucket < OVERRUN_BUCKETS_COUNT - 1 && ratio >= bounds[bucket])
+            ++bucket;
+        ++overrun_histogram_[bucket];
+        ++misses_;
+        overrun_max_ = std::max(std::chrono::duration_cast<std::chrono::microseconds>(
+                                overrun).count() / 1000000.0, overrun_max_);
+
+        lock_ = false;
+    }
+    /*!
+     * \return The number of deadline misses.
+     */
+    unsigned long misses() const { return misses_; }
+
+    void reset()
+    {
+        while (lock_.exchange(true));
+
+        iterations_ = 0;
+        jitter_ = 0;
+        jitter_max_ = 0;
+        drift_ = 0;
+        misses_ = 0;
+        overrun_max_ = 0;
+        for (auto &count : overrun_histogram_)
+            count = 0;
+
+        lock_ = false;
+    }
+    /*! \brief Fill the jitter and drift fields of the statistics.
+     */
+    void timeStatistics(TimeStatistics &t)
+    {
+        while (lock_.exchange(true));
+
+        t.jitter_mean = iterations_ > 0 ? jitter_ / iterations_ : 0;
+        t.jitter_max = jitter_max_;
+        t.drift = drift_;
+        t.periodic = true;
+        t.deadline_misses = misses_;
+        t.overrun_max = overrun_max_;
+        t.overrun_histogram.assign(overrun_histogram_, overrun_histogram_ + OVERRUN_BUCKETS_COUNT);
+
+        lock_ = false;
+    }
+
+private:
+    unsigned long iterations_ = 0;
+    double jitter_ = 0;
+    double jitter_max_ = 0;
+    double drift_ = 0;
+    std::atomic<unsigned long> misses_ = {0};
+    double overrun_max_ = 0;
+    unsigned long overrun_histogram_[OVERRUN_BUCKETS_COUNT] = {};
+
+    std::atomic<bool> lock_ = {false};
+};
 
 class TimerManager
 {
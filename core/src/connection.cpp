@@ -8,7 +8,12 @@
  * file 'LICENSE.txt', which is part of this source code package.
  */
 
+#include <algorithm>
+#include <condition_variable>
+#include <map>
+#include <mutex>
 #include <string>
+#include <thread>
 
 #include "coco/task.h"
 #include "coco/connection.h"
@@ -34,6 +39,8 @@ ConnectionPolicy::ConnectionPolicy(const std::string & policy,
         data_policy = BUFFER;
     else if (policy.compare("CIRCULAR") == 0)
         data_policy = CIRCULAR;
+    else if (policy.compare("WORK_QUEUE") == 0)
+        data_policy = WORK_QUEUE;
     else
         COCO_FATAL() << "Failed to parse connection policy data type: "
                      << policy;
@@ -55,6 +62,167 @@ ConnectionPolicy::ConnectionPolicy(const std::string & policy,
                      << transport_type;
 }
 
+void ConnectionPolicy::setOverflowPolicy(const std::string &overflow_policy)
+{
+    if (overflow_policy.compare("FAIL") == 0)
+        overflow = FAIL;
+    else if (overflow_policy.compare("DROP_NEWEST") == 0)
+        overflow = DROP_NEWEST;
+    else if (overflow_policy.compare("DROP_OLDEST") == 0)
+        overflow = DROP_OLDEST;
+    else if (overflow_policy.compare("BLOCK") == 0)
+        overflow = BLOCK;
+    else
+        COCO_FATAL() << "Failed to parse connection overflow policy: "
+                     << overflow_policy;
+}
+
+void FarmPolicy::setDispatch(const std::string &dispatch_policy)
+{
+    if (dispatch_policy.compare("IDLE_FIRST") == 0)
+        dispatch = IDLE_FIRST;
+    else if (dispatch_policy.compare("JOIN_SHORTEST_QUEUE") == 0)
+        dispatch = JOIN_SHORTEST_QUEUE;
+    else if (dispatch_policy.compare("POWER_OF_TWO") == 0)
+        dispatch = POWER_OF_TWO;
+    else if (dispatch_policy.compare("LEAST_EXPECTED_COMPLETION") == 0)
+        dispatch = LEAST_EXPECTED_COMPLETION;
+    else if (dispatch_policy.compare("KEY_AFFINITY") == 0)
+        dispatch = KEY_AFFINITY;
+    else if (dispatch_policy.compare("WORK_QUEUE") == 0)
+        dispatch = WORK_QUEUE;
+    else
+        COCO_FATAL() << "Failed to parse farm dispatch policy: " << dispatch_policy;
+}
+
+const unsigned int FarmTracker::WINDOW;
+const unsigned int FarmTracker::LATENCIES;
+
+FarmTracker::FarmTracker()
+    : completed_(WINDOW), latencies_(LATENCIES)
+{}
+
+bool FarmTracker::complete(uint64_t sequence, int long latency)
+{
+    auto &slot = completed_[sequence % WINDOW];
+    if (slot.load(std::memory_order_relaxed) == sequence)
+    {
+        duplicates_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    slot.store(sequence, std::memory_order_relaxed);
+    uint64_t count = results_.load(std::memory_order_relaxed);
+    latencies_[count % LATENCIES].store(latency, std::memory_order_relaxed);
+    results_.store(count + 1, std::memory_order_release);
+    return true;
+}
+
+bool FarmTracker::completed(uint64_t sequence) const
+{
+    return completed_[sequence % WINDOW].load(std::memory_order_relaxed) == sequence;
+}
+
+int long FarmTracker::latency(double percentile) const
+{
+    unsigned int count = std::min<uint64_t>(results_.load(std::memory_order_acquire), LATENCIES);
+    if (count == 0)
+        return 0;
+    std::vector<int long> latencies(count);
+    for (unsigned int i = 0; i < count; ++i)
+        latencies[i] = latencies_[i].load(std::memory_order_relaxed);
+    auto nth = latencies.begin() + std::min<unsigned int>(percentile * count, count - 1);
+    std::nth_element(latencies.begin(), nth, latencies.end());
+    return *nth;
+}
+
+/* Pending alarms sorted by time, served by a thread started with the first alarm */
+struct FarmAlarmQueue
+{
+    static FarmAlarmQueue & instance()
+    {
+        static FarmAlarmQueue queue;
+        return queue;
+    }
+
+    ~FarmAlarmQueue()
+    {
+        {
+            std::unique_lock<std::mutex> mlock(mutex);
+            stopping = true;
+        }
+        cond.notify_all();
+        if (thread.joinable())
+            thread.join();
+    }
+
+    void push(int long time, const std::weak_ptr<FarmAlarm> &alarm)
+    {
+        {
+            std::unique_lock<std::mutex> mlock(mutex);
+            if (!thread.joinable())
+                thread = std::thread(&FarmAlarmQueue::entry, this);
+            alarms.emplace(time, alarm);
+        }
+        cond.notify_one();
+    }
+
+    void entry()
+    {
+        std::unique_lock<std::mutex> mlock(mutex);
+        while (!stopping)
+        {
+            if (alarms.empty())
+            {
+                cond.wait(mlock);
+                continue;
+            }
+            int long time = alarms.begin()->first;
+            std::chrono::steady_clock::time_point deadline{std::chrono::microseconds(time)};
+            if (std::chrono::steady_clock::now() < deadline)
+            {
+                cond.wait_until(mlock, deadline);
+                continue;
+            }
+            auto alarm = alarms.begin()->second.lock();
+            alarms.erase(alarms.begin());
+            if (!alarm)
+                continue;
+            mlock.unlock();
+            alarm->fire(time);
+            mlock.lock();
+        }
+    }
+
+    std::mutex mutex;
+    std::condition_variable cond;
+    std::multimap<int long, std::weak_ptr<FarmAlarm> > alarms;
+    bool stopping = false;
+    std::thread thread;
+};
+
+FarmAlarm::FarmAlarm(const std::shared_ptr<PortBase> &port)
+    : port_(port)
+{}
+
+void FarmAlarm::arm(int long time)
+{
+    if (time_.exchange(time) != time)
+        FarmAlarmQueue::instance().push(time, shared_from_this());
+}
+
+void FarmAlarm::fire(int long time)
+{
+    /* A request replaced or cancelled after being queued is dropped */
+    if (!time_.compare_exchange_strong(time, 0))
+        return;
+    auto port = port_.lock();
+    if (!port)
+        return;
+    /* The trigger is added before being counted, so the owner never removes a trigger not yet added */
+    port->triggerComponent();
+    fired_.fetch_add(1);
+}
+
 ConnectionBase::ConnectionBase(std::shared_ptr<PortBase> in,
                                std::shared_ptr<PortBase> out,
                                ConnectionPolicy policy)
@@ -69,21 +237,87 @@ bool ConnectionBase::hasNewData() const
 
 bool ConnectionBase::hasComponent(const std::string &name) const
 {
-    if (input_->task()->instantiationName() == name)
+    if (input_ && input_->task()->instantiationName() == name)
         return true;
-    if (output_->task()->instantiationName() == name)
+    if (output_ && output_->task()->instantiationName() == name)
         return true;
     return false;
 }
 
-void ConnectionBase::trigger()
+void ConnectionBase::trigger(unsigned int count)
+{
+    for (unsigned int i = 0; i < count; ++i)
+        input_->triggerComponent();
+}
+
+unsigned int ConnectionBase::removeTrigger(unsigned int count)
+{
+    unsigned int removed = 0;
+    while (removed < count && input_->removeTriggerComponent())
+        ++removed;
+    return removed;
+}
+
+void ConnectionBase::notify(unsigned int count)
+{
+    if (count > 0)
+        written_.fetch_add(count, std::memory_order_relaxed);
+    if (input_)
+        input_->notifyData();
+}
+
+SampleInfo ConnectionBase::stamp(unsigned int count)
+{
+    SampleInfo info;
+    info.sequence = sequence_.fetch_add(count, std::memory_order_relaxed) + 1;
+    info.timestamp = util::monotonicTime();
+    if (output_)
+        info.farm = output_->task_->farm_tag_;
+    last_write_.store(info.timestamp, std::memory_order_relaxed);
+    return info;
+}
+
+void ConnectionBase::setFarmTag(const FarmTag &tag)
+{
+    if (output_)
+        output_->task_->farm_tag_ = tag;
+}
+
+void ConnectionBase::propagateLatency(const SampleInfo *info)
 {
-    input_->triggerComponent();
+    if (!input_)
+        return;
+    /* The farm tag is carried by the data, the reading task forwards it to what it writes */
+    if (info)
+        input_->task_->farm_tag_ = info->farm;
+    if (!output_)
+        return;
+    /* Propagate timestamp to calculate latency */
+    int long latency_time = output_->task()->latencyTimestamp();
+    if (latency_time > 0)
+        input_->task()->setLatencyTimestamp(latency_time);
 }
 
-void ConnectionBase::removeTrigger()
+ConnectionStatistics ConnectionBase::statistics() const
 {
-    input_->removeTriggerComponent();
+    ConnectionStatistics stats;
+    stats.written = written_.load(std::memory_order_relaxed);
+    stats.read = read_.load(std::memory_order_relaxed);
+    stats.bytes = stats.written * sample_size_;
+    stats.dropped = dropped_.load(std::memory_order_relaxed);
+    stats.blocked_time = blocked_time_.load(std::memory_order_relaxed);
+    stats.queue_length = queueLength();
+    stats.high_water = high_water_.load(std::memory_order_relaxed);
+    stats.last_write = last_write_.load(std::memory_order_relaxed);
+    return stats;
+}
+
+void ConnectionBase::updateHighWater(unsigned int length)
+{
+    unsigned int high_water = high_water_.load(std::memory_order_relaxed);
+    while (length > high_water &&
+           !high_water_.compare_exchange_weak(high_water, length, std::memory_order_relaxed))
+    {}
 }
 
 bool ConnectionManager::addConnection(
@@ -100,7 +334,7 @@ bool ConnectionManager::hasConnections() const
 
 int ConnectionManager::queueLenght(int connection) const
 {
-    if (connection > static_cast<int>(connections_.size()))
+    if (connection >= static_cast<int>(connections_.size()))
         return 0;
     if (connection >= 0)
         return connections_[connection]->queueLength();
@@ -118,5 +352,43 @@ int ConnectionManager::connectionsCount() const
     return connections_.size();
 }
 
+ConnectionStatistics ConnectionManager::statistics(int connection) const
+{
+    if (connection >= static_cast<int>(connections_.size()))
+        return ConnectionStatistics();
+    if (connection >= 0)
+        return connections_[connection]->statistics();
+
+    ConnectionStatistics stats;
+    for (auto & conn : connections_)
+    {
+        auto conn_stats = conn->statistics();
+        stats.written += conn_stats.written;
+        stats.read += conn_stats.read;
+        stats.bytes += conn_stats.bytes;
+        stats.dropped += conn_stats.dropped;
+        stats.blocked_time += conn_stats.blocked_time;
+        stats.queue_length += conn_stats.queue_length;
+        stats.high_water = std::max(stats.high_water, conn_stats.high_water);
+        stats.last_write = std::max(stats.last_write, conn_stats.last_write);
+    }
+    return stats;
+}
+
+uint64_t ConnectionManager::droppedCount(int connection) const
+{
+    return statistics(connection).dropped;
+}
+
+uint64_t ConnectionManager::blockedTime(int connection) const
+{
+    return statistics(connection).blocked_time;
+}
+
+unsigned int ConnectionManager::highWaterMark(int connection) const
+{
+    return statistics(connection).high_water;
+}
+
 
 }  // end of namespace coco
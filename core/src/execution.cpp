@@ -12,6 +12,15 @@
 #include <thread>
 #include <mutex>
 #include <iomanip>
+#include <cerrno>
+#include <cstring>
+#include <ctime>
+#ifdef __linux__
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+#endif
 
 #include "coco/util/timing.h"
 #include "coco/util/linux_sched.h"
@@ -29,17 +38,84 @@ Activity::Activity(SchedulePolicy policy)
       guid_(guid_gen++)
 {}
 
+bool Activity::decreaseTrigger(std::atomic<int> &pending_trigger)
+{
+    /* Writers and readers can remove triggers concurrently, never go below zero */
+    int pending = pending_trigger.load();
+    while (pending > 0 && !pending_trigger.compare_exchange_weak(pending, pending - 1))
+    {}
+    return pending > 0;
+}
+
 bool Activity::isPeriodic() const
 {
     return policy_.scheduling_policy != SchedulePolicy::TRIGGERED;
 }
 
+std::chrono::steady_clock::time_point Activity::nextDeadline(std::chrono::steady_clock::time_point deadline)
+{
+    auto period = std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+            std::chrono::milliseconds(policy_.period_ms));
+    auto next = deadline + period;
+    auto now = std::chrono::steady_clock::now();
+    if (now <= next || next < catch_up_)
+        return next;
+
+    auto overrun = now - next;
+    period_timer_.miss(overrun, period);
+    double overrun_sec = std::chrono::duration_cast<std::chrono::microseconds>(overrun).count() / 1000000.0;
+    for (auto &runnable : runnable_list_)
+        runnable->deadlineMiss(overrun_sec);
+
+    switch (policy_.overrun)
+    {
+    case SchedulePolicy::SKIP_NEXT:
+        next += period * (overrun / period + 1);
+        break;
+    case SchedulePolicy::PHASE_RESET:
+        next = now;
+        break;
+    case SchedulePolicy::CATCH_UP:
+    default:
+        catch_up_ = now;
+        break;
+    }
+    return next;
+}
+
 SequentialActivity::SequentialActivity(SchedulePolicy policy)
     : Activity(policy)
-{}
+{
+#ifdef __linux__
+    epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+    event_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    timer_fd_ = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (epoll_fd_ < 0 || event_fd_ < 0 || timer_fd_ < 0)
+        COCO_FATAL() << "Failed to create the event loop of the sequential activity: " << strerror(errno);
+    for (int fd : {event_fd_, timer_fd_})
+    {
+        struct epoll_event event = {};
+        event.events = EPOLLIN;
+        event.data.fd = fd;
+        if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &event) != 0)
+            COCO_FATAL() << "Failed to add descriptor to the event loop: " << strerror(errno);
+    }
+#endif
+}
+
+SequentialActivity::~SequentialActivity()
+{
+#ifdef __linux__
+    for (int fd : {epoll_fd_, event_fd_, timer_fd_})
+        if (fd >= 0)
+            close(fd);
+#endif
+}
 
 void SequentialActivity::start()
 {
+    stopping_ = false;
+    active_ = true;
     this->entry();
 }
 
@@ -48,20 +124,33 @@ void SequentialActivity::stop()
     if (active_)
     {
         stopping_ = true;
-        if (!isPeriodic())
-            trigger();
-        else
-        {
-            // LIMIT: std::thread sleep cannot be interrupted
-        }
+#ifdef __linux__
+        uint64_t value = 1;
+        if (write(event_fd_, &value, sizeof(value)) != sizeof(value))
+        {}  // The counter is already non zero, the loop is awake
+#else
+        // LIMIT: std::thread sleep cannot be interrupted
+#endif
     }
 }
 
 void SequentialActivity::trigger()
-{}
+{
+    if (isPeriodic())
+        return;
 
-void SequentialActivity::removeTrigger()
-{}
+    ++pending_trigger_;
+#ifdef __linux__
+    uint64_t value = 1;
+    if (write(event_fd_, &value, sizeof(value)) != sizeof(value))
+    {}  // The counter is already non zero, the loop is awake
+#endif
+}
+
+bool SequentialActivity::removeTrigger()
+{
+    return decreaseTrigger(pending_trigger_);
+}
 
 void SequentialActivity::join()
 {
@@ -73,6 +162,46 @@ std::thread::id SequentialActivity::threadId() const
     return std::thread::id();
 }
 
+void SequentialActivity::armTimer(std::chrono::steady_clock::time_point deadline)
+{
+#ifdef __linux__
+    auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(deadline.time_since_epoch()).count();
+    struct itimerspec spec = {};
+    spec.it_value.tv_sec = ns / 1000000000;
+    spec.it_value.tv_nsec = ns % 1000000000;
+    if (timerfd_settime(timer_fd_, TFD_TIMER_ABSTIME, &spec, nullptr) != 0)
+        COCO_FATAL() << "Failed to set the timer of the sequential activity: " << strerror(errno);
+#else
+    std::this_thread::sleep_until(deadline);
+#endif
+}
+
+bool SequentialActivity::waitEvents()
+{
+#ifdef __linux__
+    struct epoll_event events[2];
+    int count = epoll_wait(epoll_fd_, events, 2, -1);
+    if (count < 0)
+    {
+        /* Interrupted by a signal, the handler may have stopped the activity */
+        if (errno != EINTR)
+            COCO_FATAL() << "Failed to wait on the event loop: " << strerror(errno);
+        return false;
+    }
+    bool expired = false;
+    for (int i = 0; i < count; ++i)
+    {
+        /* Reading resets the counter of the eventfd and the expirations of the timerfd */
+        uint64_t value;
+        ssize_t size = read(events[i].data.fd, &value, sizeof(value));
+        if (events[i].data.fd == timer_fd_ && size == sizeof(value))
+            expired = true;
+    }
+    return expired;
+#else
+    return true;
+#endif
+}
 
 void SequentialActivity::entry()
 {
@@ -81,31 +210,35 @@ void SequentialActivity::entry()
     /* PERIODIC */
     if (isPeriodic())
     {
-        std::chrono::system_clock::time_point next_start_time;
+        /* Absolute deadlines: the time spent in the steps does not accumulate in the period */
+        auto period = std::chrono::milliseconds(policy_.period_ms);
+        auto deadline = std::chrono::steady_clock::now();
         while (!stopping_)
         {
-            next_start_time = std::chrono::system_clock::now() +
-                              std::chrono::milliseconds(policy_.period_ms);
+            period_timer_.wakeup(deadline, std::chrono::steady_clock::now());
             for (auto &runnable : runnable_list_)
                 runnable->step();
-            std::this_thread::sleep_until(next_start_time);
+            deadline = nextDeadline(deadline);
+            armTimer(deadline);
+            while (!stopping_ && !waitEvents())
+            {}
         }
     }
     /* TRIGGERED */
     else
     {
-        while (true)
+        while (!stopping_)
         {
-            /* wait on condition variable or timer */
-            if (stopping_)
-            {
-                break;
-            }
-            else
+#ifdef __linux__
+            /* A trigger arriving after the check leaves the eventfd readable, it is not lost */
+            if (pending_trigger_ == 0)
             {
-                for (auto &runnable : runnable_list_)
-                    runnable->step();
+                waitEvents();
+                continue;
             }
+#endif
+            for (auto &runnable : runnable_list_)
+                runnable->step();
         }
     }
     active_ = false;
@@ -159,7 +292,10 @@ void ParallelActivity::stop()
     COCO_DEBUG("Activity") << "STOPPING ACTIVITY";
     if (thread_)
     {
-        stopping_ = true;
+        {
+            std::unique_lock<std::mutex> mlock(mutex_);
+            stopping_ = true;
+        }
         cond_.notify_all();
     }
 }
@@ -169,16 +305,18 @@ void ParallelActivity::trigger()
     if (isPeriodic())
         return;
     
-    ++pending_trigger_;
+    {
+        /* Taking the mutex avoids losing the notification if the activity
+         * has just checked pending_trigger_ and it is going to wait */
+        std::unique_lock<std::mutex> mlock(mutex_);
+        ++pending_trigger_;
+    }
     cond_.notify_all();
 }
 
-void ParallelActivity::removeTrigger()
+bool ParallelActivity::removeTrigger()
 {
-    if (pending_trigger_ > 0)
-    {
-        --pending_trigger_;
-    }
+    return decreaseTrigger(pending_trigger_);
 }
 
 void ParallelActivity::join()
@@ -275,21 +413,19 @@ void ParallelActivity::entry()
     /* PERIODIC */
     if (isPeriodic())
     {
+        /* Absolute deadlines on the monotonic clock, the condition variable
+         * lets stop() interrupt the wait */
+        auto period = std::chrono::milliseconds(policy_.period_ms);
+        auto deadline = std::chrono::steady_clock::now();
         while (!stopping_)
         {
-            auto now = std::chrono::system_clock::now();
+            period_timer_.wakeup(deadline, std::chrono::steady_clock::now());
             for (auto &runnable : runnable_list_)
                 runnable->step();
 
-            auto new_now = std::chrono::system_clock::now();
-            auto sleep_time =
-                    std::chrono::microseconds(policy_.period_ms * 1000) -
-                    (new_now - now);
-            if (sleep_time > std::chrono::microseconds(0))
-            {
-                std::unique_lock<std::mutex> mlock(mutex_);
-                cond_.wait_for(mlock, sleep_time);
-            }
+            deadline = nextDeadline(deadline);
+            std::unique_lock<std::mutex> mlock(mutex_);
+            cond_.wait_until(mlock, deadline, [this] () { return stopping_.load(); });
         }
     }
     /* TRIGGERED */
@@ -298,10 +434,9 @@ void ParallelActivity::entry()
         while (true)
         {
             /* wait on condition variable or timer */
-            if (pending_trigger_ == 0)
             {
                 std::unique_lock<std::mutex> mlock(mutex_);
-                cond_.wait(mlock);
+                cond_.wait(mlock, [this] () { return pending_trigger_ > 0 || stopping_; });
             }
 
             if (stopping_)
@@ -323,6 +458,209 @@ void ParallelActivity::entry()
         runnable->finalize();
 }
 
+// -------------------------------------------------------------------
+// Thread pool
+// -------------------------------------------------------------------
+namespace
+{
+/* Pool and deque of the calling thread, if it is a pool thread */
+thread_local ThreadPool *current_pool = nullptr;
+thread_local unsigned int current_worker = 0;
+}
+
+ThreadPool::ThreadPool(unsigned int threads, bool pinned)
+    : pinned_(pinned)
+{
+    if (threads == 0)
+        threads = std::max(std::thread::hardware_concurrency(), 1u);
+    for (unsigned int i = 0; i < threads; ++i)
+        workers_.emplace_back(new Worker());
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::unique_lock<std::mutex> mlock(mutex_);
+        stopping_ = true;
+    }
+    cond_.notify_all();
+    for (auto &worker : workers_)
+        if (worker->thread.joinable())
+            worker->thread.join();
+}
+
+void ThreadPool::start(const std::list<unsigned int> &cores)
+{
+    std::call_once(started_, [&] ()
+    {
+        std::vector<unsigned int> core_list(cores.begin(), cores.end());
+        for (unsigned int i = 0; i < workers_.size(); ++i)
+        {
+            workers_[i]->thread = std::thread(&ThreadPool::entry, this, i);
+#ifdef __linux__
+            if (pinned_ && !core_list.empty())
+            {
+                cpu_set_t cpu_set;
+                CPU_ZERO(&cpu_set);
+                CPU_SET(core_list[i % core_list.size()], &cpu_set);
+                if (pthread_setaffinity_np(workers_[i]->thread.native_handle(), sizeof(cpu_set_t), &cpu_set) != 0)
+                    COCO_ERR() << "Failed to pin pool thread " << i << " on core " << core_list[i % core_list.size()];
+            }
+#endif
+        }
+        COCO_DEBUG("Activity") << "Started pool of " << workers_.size() << " threads";
+    });
+}
+
+void ThreadPool::schedule(PoolActivity *activity, bool fair)
+{
+    unsigned int index = current_pool == this ? current_worker
+                                              : next_.fetch_add(1, std::memory_order_relaxed) % workers_.size();
+    {
+        auto &worker = *workers_[index];
+        std::unique_lock<std::mutex> mlock(worker.mutex);
+        if (fair)
+            worker.ready.push_front(activity);
+        else
+            worker.ready.push_back(activity);
+    }
+    queued_.fetch_add(1, std::memory_order_seq_cst);
+    /* A thread increases sleeping_ before checking queued_, under the mutex */
+    if (sleeping_.load(std::memory_order_seq_cst) > 0)
+    {
+        std::unique_lock<std::mutex> mlock(mutex_);
+        cond_.notify_one();
+    }
+}
+
+PoolActivity * ThreadPool::take(unsigned int index)
+{
+    {
+        auto &worker = *workers_[index];
+        std::unique_lock<std::mutex> mlock(worker.mutex);
+        if (!worker.ready.empty())
+        {
+            auto activity = worker.ready.back();
+            worker.ready.pop_back();
+            return activity;
+        }
+    }
+    for (unsigned int i = 1; i < workers_.size(); ++i)
+    {
+        auto &victim = *workers_[(index + i) % workers_.size()];
+        std::unique_lock<std::mutex> mlock(victim.mutex);
+        if (!victim.ready.empty())
+        {
+            auto activity = victim.ready.front();
+            victim.ready.pop_front();
+            return activity;
+        }
+    }
+    return nullptr;
+}
+
+void ThreadPool::entry(unsigned int index)
+{
+    current_pool = this;
+    current_worker = index;
+    while (true)
+    {
+        if (auto activity = take(index))
+        {
+            queued_.fetch_sub(1, std::memory_order_relaxed);
+            activity->entry();
+            continue;
+        }
+        std::unique_lock<std::mutex> mlock(mutex_);
+        sleeping_.fetch_add(1, std::memory_order_seq_cst);
+        cond_.wait(mlock, [this] () { return queued_.load(std::memory_order_seq_cst) > 0 || stopping_; });
+        sleeping_.fetch_sub(1, std::memory_order_relaxed);
+        if (stopping_ && queued_ == 0)
+            break;
+    }
+}
+
+PoolActivity::PoolActivity(SchedulePolicy policy, std::shared_ptr<ThreadPool> pool)
+    : Activity(policy), pool_(pool)
+{
+    if (isPeriodic())
+        COCO_FATAL() << "Only triggered activities can be executed by the thread pool";
+}
+
+void PoolActivity::start()
+{
+    pool_->start(policy_.available_core_id);
+    stopping_ = false;
+    active_ = true;
+    wake();
+}
+
+void PoolActivity::stop()
+{
+    COCO_DEBUG("Activity") << "STOPPING POOL ACTIVITY";
+    stopping_ = true;
+    if (active_)
+        wake();
+}
+
+void PoolActivity::trigger()
+{
+    ++pending_trigger_;
+    wake();
+}
+
+bool PoolActivity::removeTrigger()
+{
+    return decreaseTrigger(pending_trigger_);
+}
+
+void PoolActivity::join()
+{
+    std::unique_lock<std::mutex> mlock(mutex_);
+    cond_.wait(mlock, [this] () { return !active_ || finished_; });
+}
+
+std::thread::id PoolActivity::threadId() const
+{
+    return std::thread::id();
+}
+
+void PoolActivity::wake()
+{
+    if (!scheduled_.exchange(true, std::memory_order_seq_cst))
+        pool_->schedule(this);
+}
+
+void PoolActivity::entry()
+{
+    if (!initialized_)
+    {
+        for (auto &runnable : runnable_list_)
+            runnable->init();
+        initialized_ = true;
+    }
+    else if (!stopping_ && pending_trigger_ > 0)
+    {
+        for (auto &runnable : runnable_list_)
+            runnable->step();
+    }
+
+    if (stopping_)
+    {
+        for (auto &runnable : runnable_list_)
+            runnable->finalize();
+        std::unique_lock<std::mutex> mlock(mutex_);
+        finished_ = true;
+        active_ = false;
+        cond_.notify_all();
+        return;  // scheduled_ stays set, the activity is not executed any more
+    }
+    /* A trigger arrived after the check above finds scheduled_ cleared and schedules the activity */
+    scheduled_.store(false, std::memory_order_seq_cst);
+    if ((pending_trigger_ > 0 || stopping_) && !scheduled_.exchange(true, std::memory_order_seq_cst))
+        pool_->schedule(this, true);
+}
+
 // -------------------------------------------------------------------
 // Execution
 // -------------------------------------------------------------------
@@ -385,6 +723,11 @@ void ExecutionEngine::step()
     task_->setState(TaskState::IDLE);
 }
 
+void ExecutionEngine::deadlineMiss(double overrun)
+{
+    task_->onDeadlineMiss(overrun);
+}
+
 void ExecutionEngine::finalize()
 {
     if (task_->state() != TaskState::STOPPED)
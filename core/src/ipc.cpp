@@ -0,0 +1,443 @@
+/**
+ * Project: CoCo
+ * Copyright (c) 2016, Scuola Superiore Sant'Anna
+ *
+ * Authors: Filippo Brizzi <fi.brizzi@sssup.it>, Emanuele Ruffaldi
+ *
+ * This file is subject to the terms and conditions defined in
+ * file 'LICENSE.txt', which is part of this source code package.
+ */
+
+#include <thread>
+#include <chrono>
+#include <cstring>
+
+#ifndef WIN32
+#include <pthread.h>
+#include <signal.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <climits>
+#endif
+
+#include "coco/util/logging.h"
+#include "coco/util/ipc.h"
+
+namespace coco
+{
+namespace util
+{
+
+#ifndef WIN32
+
+namespace
+{
+enum { HEADER_NOT_INIT = 0, HEADER_INITIALIZING = 1, HEADER_READY = 2, HEADER_REMOVED = 3 };
+const unsigned int MAX_USERS = 16;
+const int INIT_TIMEOUT_MS = 1000;
+const int ATTACH_ATTEMPTS = 3;
+
+/* The state packs the generation, the pid of the process that initialized the segment
+ * and the phase, so that a process taking over a failed initialization does it with a single CAS */
+uint64_t makeState(uint32_t generation, pid_t owner, uint32_t phase)
+{
+    return (static_cast<uint64_t>(generation) << 32) | (static_cast<uint64_t>(owner) << 2) | phase;
+}
+uint32_t statePhase(uint64_t state) { return state & 3; }
+pid_t stateOwner(uint64_t state) { return static_cast<pid_t>((state & 0xffffffff) >> 2); }
+uint32_t stateGeneration(uint64_t state) { return state >> 32; }
+
+bool processDead(pid_t pid)
+{
+    return pid > 0 && kill(pid, 0) < 0 && errno == ESRCH;
+}
+}  // end of anonymous namespace
+
+/* Layout of the beginning of the segment. It is followed by the element slots.
+ * The fields are written only holding the process shared mutex, apart from
+ * state, used to synchronize the initialization, sequence, used as futex word,
+ * and waiters, telling the writers whether to wake the futex.
+ */
+struct SharedMemoryRing::Header
+{
+    std::atomic<uint64_t> state;  // See makeState()
+    std::atomic<uint32_t> sequence;
+    std::atomic<uint32_t> waiters;  // Threads waiting on the futex
+    uint32_t capacity;
+    uint64_t element_size;
+    uint64_t head;
+    uint64_t count;
+    pid_t users[MAX_USERS];  // Processes that opened the ring, 0 for a free entry
+    pthread_mutex_t mutex;
+};
+
+/* Holds the process shared mutex. If its owner died the ring may be half written, so it is emptied */
+class SharedMemoryRing::Lock
+{
+public:
+    explicit Lock(const SharedMemoryRing &ring) : header_(ring.header_)
+    {
+        int res = pthread_mutex_lock(&header_->mutex);
+        if (res == EOWNERDEAD)
+        {
+            COCO_ERR() << "A process died holding the lock of shared memory segment " << ring.name_
+                       << ", its content is discarded";
+            header_->head = 0;
+            header_->count = 0;
+            pthread_mutex_consistent(&header_->mutex);
+        }
+        else if (res != 0)
+        {
+            COCO_FATAL() << "Failed to lock shared memory segment " << ring.name_ << ": " << strerror(res);
+        }
+    }
+    ~Lock() { pthread_mutex_unlock(&header_->mutex); }
+private:
+    Header *header_;
+};
+
+size_t SharedMemoryRing::headerSize()
+{
+    /* Keep the slots cache line aligned */
+    return (sizeof(Header) + 63) & ~static_cast<size_t>(63);
+}
+
+SharedMemoryRing::SharedMemoryRing(const std::string &name, unsigned int capacity,
+                                   size_t element_size, bool overwrite)
+    : name_(name), overwrite_(overwrite)
+{
+    if (capacity == 0)
+        capacity = 1;
+    size_ = headerSize() + capacity * element_size;
+    for (int attempt = 0; attempt < ATTACH_ATTEMPTS; ++attempt)
+    {
+        if (!map(size_))
+            return;
+        if (attach(capacity, element_size))
+            return;
+        unmap();
+    }
+    COCO_ERR() << "Failed to attach to shared memory segment " << name_ << ", it keeps being removed";
+}
+
+SharedMemoryRing::~SharedMemoryRing()
+{
+    if (!header_)
+        return;
+    {
+        Lock lock(*this);
+        bool self = false;
+        bool last = true;
+        for (auto &user : header_->users)
+        {
+            if (user == getpid() && !self)
+            {
+                user = 0;
+                self = true;
+            }
+            else if (user != 0 && !processDead(user))
+            {
+                last = false;
+            }
+        }
+        /* Removed under the lock, a process attaching meanwhile sees it and opens a new segment */
+        if (last)
+        {
+            uint64_t state = header_->state;
+            header_->state = makeState(stateGeneration(state), stateOwner(state), HEADER_REMOVED);
+            shm_unlink(name_.c_str());
+        }
+    }
+    unmap();
+}
+
+bool SharedMemoryRing::attach(unsigned int capacity, size_t element_size)
+{
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(INIT_TIMEOUT_MS);
+    while (true)
+    {
+        uint64_t state = header_->state;
+        uint32_t phase = statePhase(state);
+        if (phase == HEADER_READY)
+            break;
+        if (phase == HEADER_REMOVED)
+            return false;
+        /* Take over the initialization if nobody started it, or if its process died or hangs */
+        if (phase == HEADER_NOT_INIT ||
+            processDead(stateOwner(state)) || std::chrono::steady_clock::now() > deadline)
+        {
+            uint64_t initializing = makeState(stateGeneration(state) + 1, getpid(), HEADER_INITIALIZING);
+            if (header_->state.compare_exchange_strong(state, initializing))
+            {
+                if (phase == HEADER_INITIALIZING)
+                    COCO_ERR() << "Initialization of shared memory segment " << name_ << " by process "
+                               << stateOwner(state) << " did not complete, initializing it again";
+                initialize(capacity, element_size);
+                /* Fails if another process took over because this one was too slow, wait for it */
+                header_->state.compare_exchange_strong(
+                    initializing, makeState(stateGeneration(state) + 1, getpid(), HEADER_READY));
+                deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(INIT_TIMEOUT_MS);
+            }
+            continue;
+        }
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+
+    {
+        Lock lock(*this);
+        if (statePhase(header_->state) == HEADER_REMOVED)
+            return false;
+        pid_t *free_user = nullptr;
+        bool stale = true;
+        for (auto &user : header_->users)
+        {
+            if (user != 0 && processDead(user))
+                user = 0;
+            if (user != 0)
+                stale = false;
+            else if (!free_user)
+                free_user = &user;
+        }
+        /* Left by processes that are all dead, their data is discarded and the layout can change */
+        if (stale && (header_->count > 0 ||
+                      header_->capacity != capacity || header_->element_size != element_size))
+        {
+            COCO_LOG(1) << "Shared memory segment " << name_ << " left by terminated processes, initializing it again";
+            header_->capacity = capacity;
+            header_->element_size = element_size;
+            header_->head = 0;
+            header_->count = 0;
+        }
+        if (header_->capacity == capacity && header_->element_size == element_size)
+        {
+            if (free_user)
+                *free_user = getpid();
+            else
+                COCO_ERR() << "Too many processes using shared memory segment " << name_
+                           << ", it may be removed while in use";
+            return true;
+        }
+    }
+    COCO_ERR() << "Shared memory segment " << name_ << " already exists with capacity "
+               << header_->capacity << " and element size " << header_->element_size
+               << ", requested " << capacity << " and " << element_size;
+    unmap();
+    return true;
+}
+
+void SharedMemoryRing::initialize(unsigned int capacity, size_t element_size)
+{
+    pthread_mutexattr_t attr;
+    pthread_mutexattr_init(&attr);
+    pthread_mutexattr_setpshared(&attr, PTHREAD_PROCESS_SHARED);
+    pthread_mutexattr_setrobust(&attr, PTHREAD_MUTEX_ROBUST);
+    pthread_mutex_init(&header_->mutex, &attr);
+    pthread_mutexattr_destroy(&attr);
+    header_->capacity = capacity;
+    header_->element_size = element_size;
+    header_->head = 0;
+    header_->count = 0;
+    header_->sequence = 0;
+    header_->waiters = 0;
+    for (auto &user : header_->users)
+        user = 0;
+}
+
+bool SharedMemoryRing::map(size_t size)
+{
+    int fd = shm_open(name_.c_str(), O_RDWR | O_CREAT, 0666);
+    if (fd < 0)
+    {
+        COCO_ERR() << "Failed to open shared memory segment " << name_ << ": " << strerror(errno);
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) < 0 ||
+        (static_cast<size_t>(st.st_size) < size && ftruncate(fd, size) < 0))
+    {
+        COCO_ERR() << "Failed to resize shared memory segment " << name_ << ": " << strerror(errno);
+        close(fd);
+        return false;
+    }
+    void *addr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (addr == MAP_FAILED)
+    {
+        COCO_ERR() << "Failed to map shared memory segment " << name_ << ": " << strerror(errno);
+        return false;
+    }
+    header_ = static_cast<Header *>(addr);
+    data_ = static_cast<char *>(addr) + headerSize();
+    return true;
+}
+
+void SharedMemoryRing::unmap()
+{
+    munmap(header_, size_);
+    header_ = nullptr;
+    data_ = nullptr;
+}
+
+char *SharedMemoryRing::slot(uint64_t index) const
+{
+    return data_ + (index % header_->capacity) * header_->element_size;
+}
+
+bool SharedMemoryRing::push(const void *element)
+{
+    {
+        Lock lock(*this);
+        if (header_->count == header_->capacity)
+        {
+            if (!overwrite_)
+                return false;
+            header_->head = (header_->head + 1) % header_->capacity;
+            --header_->count;
+        }
+        std::memcpy(slot(header_->head + header_->count), element, header_->element_size);
+        ++header_->count;
+        ++header_->sequence;
+    }
+    if (header_->waiters > 0)
+        wakeAll();
+    return true;
+}
+
+bool SharedMemoryRing::pop(void *element)
+{
+    Lock lock(*this);
+    if (header_->count == 0)
+        return false;
+    std::memcpy(element, slot(header_->head), header_->element_size);
+    header_->head = (header_->head + 1) % header_->capacity;
+    --header_->count;
+    return true;
+}
+
+unsigned int SharedMemoryRing::push(const void *elements, unsigned int n)
+{
+    const char *src = static_cast<const char *>(elements);
+    unsigned int count = 0;
+    {
+        Lock lock(*this);
+        for (; count < n; ++count)
+        {
+            if (header_->count == header_->capacity)
+            {
+                if (!overwrite_)
+                    break;
+                header_->head = (header_->head + 1) % header_->capacity;
+                --header_->count;
+            }
+            std::memcpy(slot(header_->head + header_->count),
+                        src + count * header_->element_size, header_->element_size);
+            ++header_->count;
+        }
+        header_->sequence += count;
+    }
+    if (count > 0 && header_->waiters > 0)
+        wakeAll();
+    return count;
+}
+
+unsigned int SharedMemoryRing::pop(void *elements, unsigned int n)
+{
+    char *dst = static_cast<char *>(elements);
+    Lock lock(*this);
+    unsigned int count = 0;
+    for (; count < n && header_->count > 0; ++count)
+    {
+        std::memcpy(dst + count * header_->element_size, slot(header_->head), header_->element_size);
+        header_->head = (header_->head + 1) % header_->capacity;
+        --header_->count;
+    }
+    return count;
+}
+
+bool SharedMemoryRing::popNewest(void *element)
+{
+    Lock lock(*this);
+    if (header_->count == 0)
+        return false;
+    std::memcpy(element, slot(header_->head + header_->count - 1), header_->element_size);
+    header_->head = 0;
+    header_->count = 0;
+    return true;
+}
+
+unsigned int SharedMemoryRing::size() const
+{
+    Lock lock(*this);
+    return header_->count;
+}
+
+uint32_t SharedMemoryRing::sequence() const
+{
+    return header_->sequence;
+}
+
+uint32_t SharedMemoryRing::wait(uint32_t sequence, int timeout_ms) const
+{
+    if (header_->sequence != sequence)
+        return header_->sequence;
+#ifdef __linux__
+    struct timespec timeout;
+    timeout.tv_sec = timeout_ms / 1000;
+    timeout.tv_nsec = (timeout_ms % 1000) * 1000000;
+    /* Announced before checking the sequence again, a push either sees the waiter or is seen by the futex */
+    ++header_->waiters;
+    /* Not private futex, the word is shared between processes */
+    syscall(SYS_futex, reinterpret_cast<uint32_t *>(&header_->sequence),
+            FUTEX_WAIT, sequence, &timeout, nullptr, 0);
+    --header_->waiters;
+#else
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+#endif
+    return header_->sequence;
+}
+
+void SharedMemoryRing::wakeAll() const
+{
+#ifdef __linux__
+    syscall(SYS_futex, reinterpret_cast<uint32_t *>(&header_->sequence),
+            FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+#endif
+}
+
+#else
+
+struct SharedMemoryRing::Header {};
+
+size_t SharedMemoryRing::headerSize() { return 0; }
+SharedMemoryRing::SharedMemoryRing(const std::string &name, unsigned int capacity,
+                                   size_t element_size, bool overwrite)
+    : name_(name), overwrite_(overwrite)
+{
+    COCO_ERR() << "IPC transport is not supported on this platform";
+}
+SharedMemoryRing::~SharedMemoryRing() {}
+bool SharedMemoryRing::map(size_t size) { return false; }
+void SharedMemoryRing::unmap() {}
+bool SharedMemoryRing::attach(unsigned int capacity, size_t element_size) { return false; }
+void SharedMemoryRing::initialize(unsigned int capacity, size_t element_size) {}
+char *SharedMemoryRing::slot(uint64_t index) const { return nullptr; }
+bool SharedMemoryRing::push(const void *element) { return false; }
+bool SharedMemoryRing::pop(void *element) { return false; }
+unsigned int SharedMemoryRing::push(const void *elements, unsigned int n) { return 0; }
+unsigned int SharedMemoryRing::pop(void *elements, unsigned int n) { return 0; }
+bool SharedMemoryRing::popNewest(void *element) { return false; }
+unsigned int SharedMemoryRing::size() const { return 0; }
+uint32_t SharedMemoryRing::sequence() const { return 0; }
+uint32_t SharedMemoryRing::wait(uint32_t sequence, int timeout_ms) const { return sequence; }
+void SharedMemoryRing::wakeAll() const {}
+
+#endif
+
+}  // end of namespace util
+}  // end of namespace coco
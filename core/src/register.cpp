@@ -358,6 +358,80 @@ const std::vector<std::shared_ptr<Activity>>& ComponentRegistry::activities()
     return get().activities_;
 }
 
+std::vector<ConnectionTelemetry> ComponentRegistry::connections()
+{
+    return get().connectionsImpl();
+}
+std::vector<ConnectionTelemetry> ComponentRegistry::connectionsImpl() const
+{
+    std::vector<ConnectionTelemetry> connections;
+    for (auto &task : tasks_)
+    {
+        for (auto &port : task.second->ports())
+        {
+            if (!port.second->connectionManager())
+                continue;
+            auto &port_connections = port.second->connectionManager()->connections();
+            for (auto &connection : port_connections)
+            {
+                /* Each connection is listed by its output port, or by the input port
+                 * if the writer lives in another process */
+                if (!port.second->isOutput() && connection->output())
+                    continue;
+
+                ConnectionTelemetry telemetry;
+                if (connection->output())
+                {
+                    telemetry.src_task = connection->output()->task()->instantiationName();
+                    telemetry.src_port = connection->output()->name();
+                }
+                else
+                {
+                    telemetry.src_port = connection->policy().name_id;
+                }
+                if (connection->input())
+                {
+                    telemetry.dest_task = connection->input()->task()->instantiationName();
+                    telemetry.dest_port = connection->input()->name();
+                }
+                else
+                {
+                    telemetry.dest_port = connection->policy().name_id;
+                }
+                telemetry.statistics = connection->statistics();
+                connections.push_back(telemetry);
+            }
+        }
+    }
+    return connections;
+}
+
+std::vector<FarmTelemetry> ComponentRegistry::farms()
+{
+    return get().farmsImpl();
+}
+std::vector<FarmTelemetry> ComponentRegistry::farmsImpl() const
+{
+    std::vector<FarmTelemetry> farms;
+    for (auto &task : tasks_)
+    {
+        for (auto &port : task.second->ports())
+        {
+            if (!port.second->isOutput() || !port.second->connectionManager())
+                continue;
+            /* Only the manager of a farm source has workers */
+            FarmTelemetry telemetry;
+            telemetry.statistics = port.second->farmStatistics();
+            if (telemetry.statistics.max_workers == 0)
+                continue;
+            telemetry.src_task = task.second->instantiationName();
+            telemetry.src_port = port.second->name();
+            farms.push_back(telemetry);
+        }
+    }
+    return farms;
+}
+
 }  // end of namespace coco
 
 extern "C"
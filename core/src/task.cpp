@@ -70,7 +70,42 @@ unsigned int PortBase::connectionsCount() const
 
 unsigned int PortBase::queueLength(int connection) const
 {
-    return manager_->queueLenght();
+    return manager_->queueLenght(connection);
+}
+
+ConnectionStatistics PortBase::statistics(int connection) const
+{
+    return manager_->statistics(connection);
+}
+
+uint64_t PortBase::droppedCount(int connection) const
+{
+    return manager_->droppedCount(connection);
+}
+
+uint64_t PortBase::blockedTime(int connection) const
+{
+    return manager_->blockedTime(connection);
+}
+
+unsigned int PortBase::highWaterMark(int connection) const
+{
+    return manager_->highWaterMark(connection);
+}
+
+uint64_t PortBase::reorderedCount() const
+{
+    return manager_->reorderedCount();
+}
+
+uint64_t PortBase::discardedCount() const
+{
+    return manager_->discardedCount();
+}
+
+FarmStatistics PortBase::farmStatistics() const
+{
+    return manager_->farmStatistics();
 }
 
 void PortBase::triggerComponent()
@@ -78,9 +113,33 @@ void PortBase::triggerComponent()
     task_->triggerActivity(this->name_);
 }
 
-void PortBase::removeTriggerComponent()
+bool PortBase::removeTriggerComponent()
 {
-    task_->removeTriggerActivity();
+    return task_->removeTriggerActivity();
+}
+
+void PortBase::notifyData()
+{
+    ++data_sequence_;
+    /* Lock only if someone is waiting, so that writers pay a single atomic load otherwise */
+    if (data_waiters_ > 0)
+    {
+        std::unique_lock<std::mutex> mlock(wait_mutex_);
+        wait_cond_.notify_all();
+    }
+}
+
+bool PortBase::waitData(uint32_t sequence, const std::chrono::steady_clock::time_point &deadline)
+{
+    ++data_waiters_;
+    bool notified;
+    {
+        std::unique_lock<std::mutex> mlock(wait_mutex_);
+        notified = wait_cond_.wait_until(mlock, deadline,
+                                         [&] () { return data_sequence_ != sequence; });
+    }
+    --data_waiters_;
+    return notified;
 }
 
 bool PortBase::addConnection(std::shared_ptr<ConnectionBase> &connection)
@@ -91,6 +150,7 @@ bool PortBase::addConnection(std::shared_ptr<ConnectionBase> &connection)
     }
 
     manager_->addConnection(connection);
+    connectionsChanged();
     return true;
 }
 
@@ -205,11 +265,28 @@ TaskContext::TaskContext()
 void TaskContext::stop()
 {}
 
+void TaskContext::onDeadlineMiss(double overrun)
+{}
+
 bool TaskContext::isOnSameThread(const std::shared_ptr<TaskContext> &other) const
 {
     return this->actvityId() == other->actvityId();
 }
 
+bool TaskContext::runsBefore(const std::shared_ptr<TaskContext> &other) const
+{
+    if (!isOnSameThread(other))
+        return false;
+    for (auto &runnable : activity_->runnables())
+    {
+        if (runnable == engine_)
+            return true;
+        if (runnable == other->engine_)
+            return false;
+    }
+    return false;
+}
+
 uint32_t TaskContext::actvityId() const
 {
     return activity_->id();
@@ -253,18 +330,23 @@ void TaskContext::triggerActivity(const std::string &port_name)
     }
 }
 
-void TaskContext::removeTriggerActivity()
+bool TaskContext::removeTriggerActivity()
 {
-    activity_->removeTrigger();
+    return activity_->removeTrigger();
 }
 
 util::TimeStatistics TaskContext::timeStatistics()
 {
-    return engine_->timeStatistics();
+    auto stats = engine_->timeStatistics();
+    if (activity_ && activity_->isPeriodic())
+        activity_->periodTimer().timeStatistics(stats);
+    return stats;
 }
 
 void TaskContext::resetTimeStatistics()
 {
+    if (activity_)
+        activity_->periodTimer().reset();
     return engine_->resetTimeStatistics();
 }
 
@@ -146,6 +146,9 @@ static const std::string TaskStateDesc[] =
 static const std::string SchedulePolicyDesc[] =
 { "PERIODIC", "HARD", "TRIGGERED" };
 
+static const std::string OverrunDesc[] =
+{ "CATCH_UP", "SKIP_NEXT", "PHASE_RESET" };
+
 std::string WebServer::WebServerImpl::buildJSON()
 {
     Json::Value root;
@@ -166,6 +169,15 @@ std::string WebServer::WebServerImpl::buildJSON()
         jact["periodic"] = v->isPeriodic() ? "Yes" : "No";
         jact["period"] = v->period();
         jact["policy"] = SchedulePolicyDesc[v->policy().scheduling_policy];
+        jact["overrun"] = v->isPeriodic() ? OverrunDesc[v->policy().overrun] : "-";
+        util::TimeStatistics period_stats;
+        v->periodTimer().timeStatistics(period_stats);
+        jact["misses"] = static_cast<Json::UInt64>(period_stats.deadline_misses);
+        jact["overrun_max"] = period_stats.deadline_misses > 0 ? format(period_stats.overrun_max) : "-";
+        std::string histogram;
+        for (auto count : period_stats.overrun_histogram)
+            histogram += (histogram.empty() ? "" : " / ") + std::to_string(count);
+        jact["overrun_histogram"] = period_stats.deadline_misses > 0 ? histogram : "-";
         acts.append(jact);
     }
     Json::Value& tasks = root["tasks"];
@@ -200,8 +212,50 @@ std::string WebServer::WebServerImpl::buildJSON()
         jtask["time_exec_stddev"] = format(time.service_variance);
         jtask["time_min"] = format(time.min);
         jtask["time_max"] = format(time.max);
+        jtask["jitter_mean"] = time.periodic ? format(time.jitter_mean) : "-";
+        jtask["jitter_max"] = time.periodic ? format(time.jitter_max) : "-";
+        jtask["drift"] = time.periodic ? format(time.drift) : "-";
         stats.append(jtask);
     }
+    Json::Value& conns = root["connections"];
+    auto now = util::monotonicTime();
+    for (auto& conn : ComponentRegistry::connections())
+    {
+        Json::Value jconn;
+        const auto& cstats = conn.statistics;
+        jconn["src"] = conn.src_task.empty() ? conn.src_port : conn.src_task + "." + conn.src_port;
+        jconn["dest"] = conn.dest_task.empty() ? conn.dest_port : conn.dest_task + "." + conn.dest_port;
+        jconn["written"] = static_cast<Json::UInt64>(cstats.written);
+        jconn["read"] = static_cast<Json::UInt64>(cstats.read);
+        jconn["bytes"] = static_cast<Json::UInt64>(cstats.bytes);
+        jconn["dropped"] = static_cast<Json::UInt64>(cstats.dropped);
+        jconn["blocked_time"] = format(cstats.blocked_time / 1000.0);
+        jconn["queue_length"] = cstats.queue_length;
+        jconn["high_water"] = cstats.high_water;
+        jconn["since_last_write"] = cstats.last_write > 0 ? format((now - cstats.last_write) / 1000.0) : "-";
+        conns.append(jconn);
+    }
+    Json::Value& farms = root["farms"];
+    for (auto& farm : ComponentRegistry::farms())
+    {
+        Json::Value jfarm;
+        const auto& fstats = farm.statistics;
+        jfarm["src"] = farm.src_task + "." + farm.src_port;
+        jfarm["workers"] = fstats.workers;
+        jfarm["min_workers"] = fstats.min_workers;
+        jfarm["max_workers"] = fstats.max_workers;
+        jfarm["rejected"] = static_cast<Json::UInt64>(fstats.rejected);
+        jfarm["key_spilled"] = static_cast<Json::UInt64>(fstats.key_spilled);
+        jfarm["scale_up"] = static_cast<Json::UInt64>(fstats.scale_up);
+        jfarm["scale_down"] = static_cast<Json::UInt64>(fstats.scale_down);
+        jfarm["since_last_scale"] = fstats.last_scale > 0 ? format((now - fstats.last_scale) / 1000.0) : "-";
+        jfarm["dispatched"] = static_cast<Json::UInt64>(fstats.dispatched);
+        jfarm["speculated"] = static_cast<Json::UInt64>(fstats.speculated);
+        jfarm["duplicates"] = static_cast<Json::UInt64>(fstats.duplicates);
+        jfarm["latency_p50"] = fstats.latency_p50 > 0 ? format(fstats.latency_p50 / 1000.0) : "-";
+        jfarm["latency_p99"] = fstats.latency_p99 > 0 ? format(fstats.latency_p99 / 1000.0) : "-";
+        farms.append(jfarm);
+    }
 
     Json::StreamWriterBuilder builder;
     builder["commentStyle"] = "None";
@@ -17,5 +17,6 @@
 #include <coco/util/timing.h>
 #include <coco/task_impl.hpp>
 #include <coco/connection_impl.hpp>
+#include <coco/farm_reducer.hpp>
 #include <coco/execution.h>
 #include <coco/register.h>
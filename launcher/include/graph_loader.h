@@ -40,6 +40,17 @@ private:
     void startActivity(std::unique_ptr<ActivitySpec> &activity_spec);
     void startPipeline(std::unique_ptr<PipelineSpec> &pipeline_spec);
     void startFarm(std::unique_ptr<FarmSpec> &farm_spec);
+    /*!
+     * \return The pool executing the "pool" activities, created at the first call.
+     */
+    std::shared_ptr<ThreadPool> threadPool();
+    /* Task and port writing the results of a farm */
+    using ResultProducer = std::pair<std::shared_ptr<TaskSpec>, std::string>;
+    /*! \brief Load the tree of reducers combining the results of the producers.
+     *  \return The root of the tree.
+     */
+    std::vector<ResultProducer> startReduction(std::unique_ptr<FarmSpec> &farm_spec,
+                                               std::vector<ResultProducer> producers);
     bool loadTask(std::shared_ptr<TaskSpec> &task_spec, std::shared_ptr<TaskContext> &task_owner);
     void makeConnection(std::unique_ptr<ConnectionSpec> &connection_spec);
 
@@ -59,6 +70,7 @@ private:
 
     std::unordered_map<std::string, std::shared_ptr<TaskContext>> tasks_;
     std::vector<std::shared_ptr<Activity>> activities_;
+    std::shared_ptr<ThreadPool> pool_;
 
     std::list<std::string> peers_;
 
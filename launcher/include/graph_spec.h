@@ -27,6 +27,12 @@ struct AttributeSpec
 	std::string value = "";
 };
 
+struct PortSpec
+{
+	std::string name = "";
+	std::string manager = "";  // Type of connection manager of the port: DEFAULT or FAN_IN
+};
+
 struct TaskSpec
 {
 	std::string name = "";
@@ -35,6 +41,7 @@ struct TaskSpec
 	bool is_peer = false;
 
 	std::vector<AttributeSpec> attributes;
+	std::vector<PortSpec> ports;
 	std::vector<std::shared_ptr<TaskSpec> > peers;
 };
 
@@ -44,6 +51,10 @@ struct ConnectionPolicySpec
 	std::string policy = "";
 	std::string transport = "";
 	std::string buffersize = "";
+	std::string name = "";  // Optional, identifies IPC connections between processes
+	bool broadcast = false;  // Optional, share a single read-only sample between the connections of the port
+	std::string overflow = "";  // Optional, FAIL, DROP_NEWEST, DROP_OLDEST or BLOCK
+	int overflow_timeout = 0;  // Optional, ms a writer can be blocked with BLOCK overflow policy
 };
 
 struct ConnectionSpec
@@ -65,6 +76,8 @@ struct SchedulePolicySpec
 	int priority = 0;
 	int runtime = 0;
 	bool exclusive = false;
+	std::string overrun = "";  // Policy when a periodic activity misses a deadline
+	bool pool = false;  // Executed by the thread pool of the application, only triggered
 };
 
 struct ActivityBase
@@ -86,6 +99,7 @@ struct PipelineSpec : public ActivityBase
     std::vector<std::string> out_ports;
     std::vector<std::string> in_ports;
     bool parallel = true;
+    bool pool = false;  // Each stage is executed by the thread pool instead of its own thread
 };
 
 struct FarmSpec : public ActivityBase
@@ -97,7 +111,20 @@ struct FarmSpec : public ActivityBase
     std::string source_port = "";
     std::shared_ptr<TaskSpec> gather_task;
     std::string gather_port = "";
-    unsigned int num_workers = 1;
+    unsigned int num_workers = 1;   // Workers instantiated, for an elastic farm the ones active at start
+    unsigned int min_workers = 0;   // Elastic farm: minimum number of active workers
+    unsigned int max_workers = 0;   // Elastic farm: workers instantiated, 0 if the farm is not elastic
+    int scale_interval = 100;       // Elastic farm: time in ms between two scaling decisions
+    double speculation = 0;         // Multiple of the median completion time after which an item is dispatched again
+    std::string reducer = "";       // Component registered with COCO_FARM_REDUCER, empty for no reduction tree
+    unsigned int reduce_fan_in = 2; // Inputs of each reducer of the tree
+    std::string dispatch = "";      // Dispatch policy of the source, see FarmPolicy::Dispatch
+    unsigned int worker_queue = 1;  // Items that can be queued for each worker
+    double key_imbalance = 0.25;    // Load above the mean accepted by the owner of a key, see FarmPolicy
+    bool ordered = true;            // The gather receives the results in dispatch order
+    int discard_old_data = 0;       // Time in ms after which results are discarded, 0 to keep them all
+    unsigned int reorder_size = 0;  // Results waiting for an older one, 0 for twice the workers
+    int reorder_timeout = 100;      // Time in ms after which a result stops waiting for an older one
 };
 
 struct ExportedAttributeSpec
@@ -126,6 +153,9 @@ struct TaskGraphSpec
 
 	std::vector<std::string> resources_paths;
 
+	unsigned int pool_threads = 0;  // Threads of the pool executing the "pool" activities, 0 one per core
+	bool pool_pinned = false;       // Pin each thread of the pool to a core
+
 	// TODO: add exported attribute and external ports
 	std::vector<std::shared_ptr<ExportedAttributeSpec> > exported_attributes;
 	std::vector<std::shared_ptr<ExportedPortSpec> > exported_ports;
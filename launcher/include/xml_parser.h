@@ -30,6 +30,7 @@ public:
 private:
 	void parseLogConfig(tinyxml2::XMLElement *logconfig);
 	void parsePaths(tinyxml2::XMLElement *paths);
+    void parsePool(tinyxml2::XMLElement *pool);
     void parseIncludes(tinyxml2::XMLElement *includes);
     void parseInclude(tinyxml2::XMLElement *include);
 	void parseComponents(tinyxml2::XMLElement *components,
@@ -39,6 +40,8 @@ private:
     //std::string findLibrary(const std::string & library_name);
 	void parseAttribute(tinyxml2::XMLElement *attributes,
                         TaskSpec * task_spec);
+	void parsePorts(tinyxml2::XMLElement *ports,
+                    TaskSpec * task_spec);
     std::string checkResource(const std::string &resource, bool is_library = false);
 	void parseConnections(tinyxml2::XMLElement *connections);
 	void parseConnection(tinyxml2::XMLElement *connection);
@@ -124,8 +124,9 @@ void launchApp(const std::string & config_file_path, bool profiling,
 		}
 	}
 
+	/* The sequential activity returns after the signal handler has already notified */
 	std::unique_lock<std::mutex> mlock(launcher_mutex);
-	launcher_condition_variable.wait(mlock);
+	launcher_condition_variable.wait(mlock, [] () { return stop_execution.load(); });
 }
 
 
@@ -122,6 +122,13 @@ void GraphLoader::loadSchedule(const SchedulePolicySpec &policy_spec, SchedulePo
 	else
 		policy.realtime = SchedulePolicy::NONE;
 
+	if (policy_spec.overrun == "skip_next")
+		policy.overrun = SchedulePolicy::SKIP_NEXT;
+	else if (policy_spec.overrun == "phase_reset")
+		policy.overrun = SchedulePolicy::PHASE_RESET;
+	else
+		policy.overrun = SchedulePolicy::CATCH_UP;
+
 	policy.priority = policy_spec.priority;
 	policy.runtime = policy_spec.runtime;
 }
@@ -147,7 +154,9 @@ void GraphLoader::startActivity(std::unique_ptr<ActivitySpec> &activity_spec)
 	}
 
 	std::shared_ptr<Activity> activity;
-	if (activity_spec->is_parallel)
+	if (activity_spec->policy.pool)
+		activity = std::make_shared<PoolActivity>(policy, threadPool());
+	else if (activity_spec->is_parallel)
 		activity = std::make_shared<ParallelActivity>(policy);
 	else
 		activity = std::make_shared<SequentialActivity>(policy);
@@ -164,6 +173,16 @@ void GraphLoader::startActivity(std::unique_ptr<ActivitySpec> &activity_spec)
 	}
 }
 
+std::shared_ptr<ThreadPool> GraphLoader::threadPool()
+{
+	if (!pool_)
+	{
+		pool_ = std::make_shared<ThreadPool>(app_spec_->pool_threads, app_spec_->pool_pinned);
+		COCO_DEBUG("GraphLoader") << "Created thread pool with " << pool_->size() << " threads";
+	}
+	return pool_;
+}
+
 void GraphLoader::startPipeline(std::unique_ptr<PipelineSpec> &pipeline_spec)
 {
 	SchedulePolicy policy;
@@ -193,8 +212,11 @@ void GraphLoader::startPipeline(std::unique_ptr<PipelineSpec> &pipeline_spec)
 				<< task_spec->instance_name
 				<< " it is inside a pipeline";
 
-            std::shared_ptr<Activity> activity = std::make_shared<
-                    ParallelActivity>(policy);
+            std::shared_ptr<Activity> activity;
+            if (pipeline_spec->pool)
+                activity = std::make_shared<PoolActivity>(policy, threadPool());
+            else
+                activity = std::make_shared<ParallelActivity>(policy);
             auto & task = tasks_[task_spec->instance_name];
             activity->addRunnable(task->engine());
             task->setActivity(activity);
@@ -232,6 +254,39 @@ void GraphLoader::startFarm(std::unique_ptr<FarmSpec> &farm_spec)
 		if (disabled_components_.count(task->instance_name) != 0)
 			return;
 
+	FarmPolicy farm_policy;
+	if (!farm_spec->dispatch.empty())
+		farm_policy.setDispatch(farm_spec->dispatch);
+	farm_policy.worker_queue = std::max(farm_spec->worker_queue, 1u);
+	farm_policy.key_imbalance = farm_spec->key_imbalance;
+	farm_policy.ordered = farm_spec->ordered;
+	farm_policy.discard_old_data = farm_spec->discard_old_data;
+	farm_policy.reorder_size = farm_spec->reorder_size;
+	farm_policy.reorder_timeout = farm_spec->reorder_timeout;
+	farm_policy.speculation = farm_spec->speculation;
+	// A partial result of the reduction tree derives from many items, that have no order
+	if (!farm_spec->reducer.empty())
+	{
+		if (farm_policy.speculation > 0)
+			COCO_FATAL() << "Farm with gather " << farm_spec->gather_task->instance_name
+						 << " cannot have both speculation and reduce, duplicate results would be combined";
+		farm_policy.ordered = false;
+	}
+	// With speculation the gather tells the source which items have a result
+	std::shared_ptr<FarmTracker> farm_tracker;
+	if (farm_policy.speculation > 0)
+		farm_tracker = std::make_shared<FarmTracker>();
+	// An elastic farm instantiates all the workers it can scale to
+	unsigned int num_pipelines = farm_spec->num_workers;
+	if (farm_spec->max_workers > 0)
+	{
+		num_pipelines = farm_spec->max_workers;
+		farm_policy.workers = farm_spec->num_workers;
+		farm_policy.min_workers = farm_spec->min_workers;
+		farm_policy.max_workers = farm_spec->max_workers;
+		farm_policy.scale_interval = farm_spec->scale_interval;
+	}
+
 	// -----------------------
 	// Load source task
 	// -----------------------
@@ -248,6 +303,8 @@ void GraphLoader::startFarm(std::unique_ptr<FarmSpec> &farm_spec)
 	activity_source->addRunnable(source_task->engine());
 	source_task->setActivity(activity_source);
 	source_task->port(farm_spec->source_port)->createConnectionManager(ConnectionManagerType::FARM);
+	source_task->port(farm_spec->source_port)->connectionManager()->setFarmPolicy(farm_policy);
+	source_task->port(farm_spec->source_port)->connectionManager()->setFarmTracker(farm_tracker);
 	
 	// -----------------------
 	// Load gather task
@@ -268,10 +325,12 @@ void GraphLoader::startFarm(std::unique_ptr<FarmSpec> &farm_spec)
 		COCO_FATAL() << "Gather component " << farm_spec->gather_task->instance_name
 					 << " input port: " << farm_spec->gather_port << " is not an event port";
 	gather_task->port(farm_spec->gather_port)->createConnectionManager(ConnectionManagerType::FARM);
+	gather_task->port(farm_spec->gather_port)->connectionManager()->setFarmPolicy(farm_policy);
+	gather_task->port(farm_spec->gather_port)->connectionManager()->setFarmTracker(farm_tracker);
 
 	// Load n pipelines
 	startPipeline(farm_spec->pipelines[0]);
-	for (unsigned int i = 1; i < farm_spec->num_workers; ++i)
+	for (unsigned int i = 1; i < num_pipelines; ++i)
 	{
 		std::unique_ptr<PipelineSpec> pipeline(new PipelineSpec());
 		*pipeline = *(farm_spec->pipelines[0]);
@@ -293,27 +352,101 @@ void GraphLoader::startFarm(std::unique_ptr<FarmSpec> &farm_spec)
     policy.policy = "LOCKED";
     policy.transport = "LOCAL";
     policy.buffersize = "1";
+    // With deeper worker queues the results can also be produced in bursts
+    if (farm_policy.worker_queue > 1)
+    {
+        policy.data = "BUFFER";
+        policy.buffersize = std::to_string(farm_policy.worker_queue);
+    }
+    // The workers can also compete for the items of a single queue
+    ConnectionPolicySpec policy_dispatch = policy;
+    if (farm_policy.dispatch == FarmPolicy::WORK_QUEUE)
+    {
+        policy_dispatch.data = "WORK_QUEUE";
+        policy_dispatch.policy = "LOCK_FREE";
+        policy_dispatch.buffersize = std::to_string(std::max(farm_policy.worker_queue, 1u) * num_pipelines);
+    }
 
-
-    for (unsigned int i = 0; i < farm_spec->num_workers; ++i)
+    std::vector<ResultProducer> producers;
+    for (unsigned int i = 0; i < num_pipelines; ++i)
 	{
 	    std::unique_ptr<ConnectionSpec> connection_source(new ConnectionSpec());
-	    connection_source->policy = policy;
+	    connection_source->policy = policy_dispatch;
 	    connection_source->src_task = farm_spec->source_task;
 	    connection_source->src_port = farm_spec->source_port;
 	    connection_source->dest_task = farm_spec->pipelines[i]->tasks[0];
 	    connection_source->dest_port = farm_spec->pipelines[i]->in_ports[0];
 	    app_spec_->connections.push_back(std::move(connection_source));
 
+	    producers.emplace_back(farm_spec->pipelines[i]->tasks.back(), farm_spec->pipelines[i]->out_ports.back());
+    }
+    // The gather receives the results from the workers or from the root of the reduction tree
+    if (!farm_spec->reducer.empty())
+        producers = startReduction(farm_spec, producers);
+
+    for (auto &producer : producers)
+    {
 	    std::unique_ptr<ConnectionSpec> connection_gather(new ConnectionSpec());
 	    connection_gather->policy = policy;
-	    connection_gather->src_task = farm_spec->pipelines[i]->tasks.back();
-	    connection_gather->src_port = farm_spec->pipelines[i]->out_ports.back();
+	    connection_gather->src_task = producer.first;
+	    connection_gather->src_port = producer.second;
 	    connection_gather->dest_task = farm_spec->gather_task;
 	    connection_gather->dest_port = farm_spec->gather_port;
 	    app_spec_->connections.push_back(std::move(connection_gather));
     }
+}
 
+std::vector<GraphLoader::ResultProducer> GraphLoader::startReduction(std::unique_ptr<FarmSpec> &farm_spec,
+																	 std::vector<ResultProducer> producers)
+{
+	unsigned int fan_in = std::max(farm_spec->reduce_fan_in, 2u);
+	// Partial results cannot be dropped, a full buffer blocks the writer
+	ConnectionPolicySpec policy;
+	policy.data = "BUFFER";
+	policy.policy = "LOCKED";
+	policy.transport = "LOCAL";
+	policy.buffersize = std::to_string(std::max(farm_spec->worker_queue, 16u));
+	policy.overflow = "BLOCK";
+	policy.overflow_timeout = 1000;
+
+	SchedulePolicy schedule;
+	schedule.scheduling_policy = SchedulePolicy::TRIGGERED;
+
+	// Each level combines groups of fan_in producers of the previous one, up to a single root
+	for (unsigned int level = 0; producers.size() > 1; ++level)
+	{
+		std::vector<ResultProducer> reducers;
+		for (unsigned int i = 0; i < producers.size(); i += fan_in)
+		{
+			std::shared_ptr<TaskSpec> task_spec(new TaskSpec());
+			task_spec->name = farm_spec->reducer;
+			task_spec->instance_name = farm_spec->gather_task->instance_name + "_reduce_" +
+									   std::to_string(level) + "_" + std::to_string(i / fan_in);
+			task_spec->library_name = farm_spec->gather_task->library_name;
+			std::shared_ptr<TaskContext> null_task_ptr;
+			loadTask(task_spec, null_task_ptr);
+
+			std::shared_ptr<Activity> activity = std::make_shared<ParallelActivity>(schedule);
+			auto & task = tasks_[task_spec->instance_name];
+			activity->addRunnable(task->engine());
+			task->setActivity(activity);
+			activities_.push_back(activity);
+
+			for (unsigned int j = i; j < std::min<size_t>(i + fan_in, producers.size()); ++j)
+			{
+				std::unique_ptr<ConnectionSpec> connection(new ConnectionSpec());
+				connection->policy = policy;
+				connection->src_task = producers[j].first;
+				connection->src_port = producers[j].second;
+				connection->dest_task = task_spec;
+				connection->dest_port = "value_IN";
+				app_spec_->connections.push_back(std::move(connection));
+			}
+			reducers.emplace_back(task_spec, "value_OUT");
+		}
+		producers = reducers;
+	}
+	return producers;
 }
 
 bool GraphLoader::loadTask(std::shared_ptr<TaskSpec> & task_spec,
@@ -371,6 +504,23 @@ bool GraphLoader::loadTask(std::shared_ptr<TaskSpec> & task_spec,
 			COCO_ERR() << "Attribute: " << attribute.name << " doesn't exist";
 	}
 
+	COCO_DEBUG("GraphLoader") << "Loading ports options";
+	for (auto & port_spec : task_spec->ports)
+	{
+		auto port = task->port(port_spec.name);
+		if (!port)
+		{
+			COCO_ERR() << "Port: " << port_spec.name << " doesn't exist";
+			continue;
+		}
+		if (port_spec.manager.empty() || port_spec.manager == "DEFAULT")
+			continue;
+		if (port_spec.manager == "FAN_IN" && !port->isOutput())
+			port->createConnectionManager(ConnectionManagerType::FAN_IN);
+		else
+			COCO_FATAL() << "Invalid manager " << port_spec.manager << " for port: " << port_spec.name;
+	}
+
 	// Parsing possible peers
 	COCO_DEBUG("GraphLoader") << "Loading possible peers";
 	for (auto & peer : task_spec->peers)
@@ -395,10 +545,49 @@ void GraphLoader::makeConnection(
                             connection_spec->policy.policy,
                             connection_spec->policy.transport,
                             connection_spec->policy.buffersize);
+    policy.broadcast = connection_spec->policy.broadcast;
+    if (!connection_spec->policy.overflow.empty())
+        policy.setOverflowPolicy(connection_spec->policy.overflow);
+    policy.overflow_timeout = connection_spec->policy.overflow_timeout;
 
     // if not present means the task has been disabled!
     auto src_task = tasks_.find(connection_spec->src_task->instance_name);
     auto dest_task = tasks_.find(connection_spec->dest_task->instance_name);
+
+    /* With IPC transport the task disabled in this process runs in another one,
+     * so only the local side of the connection is created.
+     */
+    if (policy.transport == ConnectionPolicy::IPC)
+    {
+        policy.name_id = connection_spec->policy.name;
+        if (policy.name_id.empty())
+            policy.name_id = "/coco_" + connection_spec->src_task->instance_name + "_" +
+                             connection_spec->src_port + "_" +
+                             connection_spec->dest_task->instance_name + "_" +
+                             connection_spec->dest_port;
+        else if (policy.name_id[0] != '/')
+            policy.name_id = "/" + policy.name_id;
+
+        if (src_task != tasks_.end() && dest_task == tasks_.end())
+        {
+            auto port = src_task->second->port(connection_spec->src_port);
+            if (!port)
+                COCO_FATAL() << "Component src: " << connection_spec->src_task->instance_name
+                             << " doesn't have port: " << connection_spec->src_port;
+            port->connectToRemote(policy);
+            return;
+        }
+        if (src_task == tasks_.end() && dest_task != tasks_.end())
+        {
+            auto port = dest_task->second->port(connection_spec->dest_port);
+            if (!port)
+                COCO_FATAL() << "Component in: " << connection_spec->dest_task->instance_name
+                             << " doesn't have port: " << connection_spec->dest_port;
+            port->connectToRemote(policy);
+            return;
+        }
+    }
+
     if (src_task == tasks_.end() || dest_task == tasks_.end())
 	{
 		COCO_ERR() << "Making connection: either src task " << connection_spec->src_task->instance_name
@@ -406,8 +595,13 @@ void GraphLoader::makeConnection(
 		return;
 	}
 
-	if (src_task->second->isOnSameThread(dest_task->second))
+	if (policy.transport == ConnectionPolicy::LOCAL &&
+		src_task->second->isOnSameThread(dest_task->second))
+	{
 		policy.lock_policy = ConnectionPolicy::UNSYNC;
+		// The reader executed after the writer finds the data in the same step without being triggered
+		policy.direct = src_task->second->runsBefore(dest_task->second);
+	}
 
     std::shared_ptr<PortBase> left = src_task->second->port(connection_spec->src_port);
     std::shared_ptr<PortBase>  right = dest_task->second->port(connection_spec->dest_port);
@@ -718,6 +912,9 @@ void GraphLoader::createGraphConnection(std::shared_ptr<TaskContext> &task,
         auto connections = port->connectionManager()->connections();
 		for (auto connection : connections)
 		{
+			/* The input is in another process */
+			if (!connection->input())
+				continue;
 			std::string port_id =
 					connection->input()->task()->instantiationName()
                             + connection->input()->name();
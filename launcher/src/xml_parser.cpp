@@ -76,6 +76,8 @@ bool XmlParser::parseFile(const std::string & config_file,
 
     parsePaths(package->FirstChildElement("paths"));
 
+    parsePool(package->FirstChildElement("pool"));
+
     COCO_DEBUG("XmlParser") << "Parsing includes";
     COCO_LOG(1) << "Parsing includes";
     parseIncludes(package->FirstChildElement("includes"));
@@ -92,6 +94,14 @@ bool XmlParser::parseFile(const std::string & config_file,
     return true;
 }
 	
+void XmlParser::parsePool(tinyxml2::XMLElement *pool)
+{
+    if (!pool)
+        return;
+    app_spec_->pool_threads = pool->UnsignedAttribute("threads");
+    app_spec_->pool_pinned = pool->BoolAttribute("pinned");
+}
+
 void XmlParser::parseLogConfig(tinyxml2::XMLElement *logconfig)
 {
 	using namespace tinyxml2;
@@ -350,6 +360,11 @@ void XmlParser::parseComponent(tinyxml2::XMLElement *component,
     XMLElement *attributes = component->FirstChildElement("attributes");
     parseAttribute(attributes, &task_spec);
 
+    /* Parsing Ports options */
+    COCO_DEBUG("XmlParser") << "Parsing ports";
+    XMLElement *ports = component->FirstChildElement("ports");
+    parsePorts(ports, &task_spec);
+
 	/* Parsing Peers */
     COCO_DEBUG("XmlParser") << "Parsing possible peers";    
     XMLElement *peers = component->FirstChildElement("components");
@@ -405,6 +420,32 @@ void XmlParser::parseAttribute(tinyxml2::XMLElement *attributes,
     }
 }
 
+void XmlParser::parsePorts(tinyxml2::XMLElement *ports,
+                           TaskSpec * task_spec)
+{
+    using namespace tinyxml2;
+
+    if (!ports)
+        return;
+
+    XMLElement *port = ports->FirstChildElement("port");
+    while (port)
+    {
+        const char *port_name = port->Attribute("name");
+        if (!port_name)
+            COCO_FATAL() << "Port of component " << task_spec->instance_name << " without name";
+
+        PortSpec port_spec;
+        port_spec.name = port_name;
+        const char *manager = port->Attribute("manager");
+        if (manager)
+            port_spec.manager = manager;
+        task_spec->ports.push_back(port_spec);
+
+        port = port->NextSiblingElement("port");
+    }
+}
+
 std::string XmlParser::checkResource(const std::string &resource, bool is_library)
 {
     std::string value = is_library ? DLLPREFIX + resource + DLLEXT : resource;
@@ -460,7 +501,14 @@ void XmlParser::parseConnection(tinyxml2::XMLElement *connection)
     connection_spec->policy.policy = connection->Attribute("policy");
     connection_spec->policy.transport = connection->Attribute("transport");
     connection_spec->policy.buffersize = connection->Attribute("buffersize");
-
+    const char *name = connection->Attribute("name");
+    if (name)
+        connection_spec->policy.name = name;
+    connection->QueryBoolAttribute("broadcast", &connection_spec->policy.broadcast);
+    const char *overflow = connection->Attribute("overflow");
+    if (overflow)
+        connection_spec->policy.overflow = overflow;
+    connection->QueryIntAttribute("overflow_timeout", &connection_spec->policy.overflow_timeout);
 
     std::string src_task = connection->FirstChildElement("src")->Attribute("task");
     auto src = app_spec_->tasks.find(src_task);
@@ -562,9 +610,10 @@ void XmlParser::parsePipeline(tinyxml2::XMLElement *pipeline)
         COCO_FATAL() << "Tag pipeline doesn't have <schedule> tag";
 
     std::string type = schedule->Attribute("activity");
-    if (type != "parallel" && type !="sequential")
-        COCO_FATAL() << "Tag pipeline support only attributes: parallel, sequential";
-    pipe_spec->parallel = (type == "parallel");
+    if (type != "parallel" && type !="sequential" && type != "pool")
+        COCO_FATAL() << "Tag pipeline support only attributes: parallel, sequential, pool";
+    pipe_spec->parallel = (type != "sequential");
+    pipe_spec->pool = (type == "pool");
 
     XMLElement *components = pipeline->FirstChildElement("components");
     if (!components)
@@ -614,11 +663,29 @@ void XmlParser::parseFarm(tinyxml2::XMLElement *farm)
     auto schedule = farm->FirstChildElement("schedule");
     if (!schedule)
         COCO_FATAL() << "Farm tag must have a schedule tag, where to specify the number of workers";
+    schedule->QueryUnsignedAttribute("min_workers", &farm_spec->min_workers);
+    schedule->QueryUnsignedAttribute("max_workers", &farm_spec->max_workers);
+    schedule->QueryIntAttribute("scale_interval", &farm_spec->scale_interval);
+    if (farm_spec->max_workers > 0 && farm_spec->max_workers <= farm_spec->min_workers)
+        COCO_FATAL() << "Schedule tag in Farm tag must have max_workers greater than min_workers";
     auto workers = schedule->Attribute("workers");
-    if (!workers)
+    if (workers)
+        farm_spec->num_workers = static_cast<unsigned int>(std::atoi(workers));
+    else if (farm_spec->max_workers > 0)
+        farm_spec->num_workers = 0;  // An elastic farm starts from the minimum
+    else
         COCO_FATAL() << "Schedule tag in Farm tag must have workers attribute "
                      << "where the number of workers is specifyed";
-    farm_spec->num_workers = static_cast<unsigned int>(std::atoi(workers));
+    const char *dispatch = schedule->Attribute("dispatch");
+    if (dispatch)
+        farm_spec->dispatch = dispatch;
+    schedule->QueryUnsignedAttribute("worker_queue", &farm_spec->worker_queue);
+    schedule->QueryDoubleAttribute("key_imbalance", &farm_spec->key_imbalance);
+    schedule->QueryBoolAttribute("ordered", &farm_spec->ordered);
+    schedule->QueryIntAttribute("discard_old_data", &farm_spec->discard_old_data);
+    schedule->QueryUnsignedAttribute("reorder_size", &farm_spec->reorder_size);
+    schedule->QueryIntAttribute("reorder_timeout", &farm_spec->reorder_timeout);
+    schedule->QueryDoubleAttribute("speculation", &farm_spec->speculation);
 
 
     // Parse source
@@ -681,6 +748,17 @@ void XmlParser::parseFarm(tinyxml2::XMLElement *farm)
         COCO_FATAL() << "Component " << name << " in Gather in Farm tag doesn't have a out attribute";
     farm_spec->gather_port = in_port;
 
+    // Optional reduction tree between the workers and the gather
+    auto reduce = gather->FirstChildElement("reduce");
+    if (reduce)
+    {
+        auto reducer = reduce->Attribute("component");
+        if (!reducer)
+            COCO_FATAL() << "Reduce tag in Gather tag in Farm tag must have a component attribute";
+        farm_spec->reducer = reducer;
+        reduce->QueryUnsignedAttribute("fan_in", &farm_spec->reduce_fan_in);
+    }
+
     app_spec_->farms.push_back(std::move(farm_spec));
 }
 
@@ -715,10 +793,17 @@ void XmlParser::parseSchedule(tinyxml2::XMLElement *schedule_policy,
     {
         is_parallel = false;
     }
+    else if (strcmp(activity, "pool") == 0 ||
+             strcmp(activity, "Pool") == 0 ||
+             strcmp(activity, "POOL") == 0)
+    {
+        is_parallel = true;
+        policy.pool = true;
+    }
     else
     {
         COCO_FATAL() << "Schduele policy: " << activity << " is not know\n" <<
-                        "Possibilities are: parallel, sequential";
+                        "Possibilities are: parallel, sequential, pool";
     }
     
     const char *activation_type = schedule_policy->Attribute("type");
@@ -739,6 +824,8 @@ void XmlParser::parseSchedule(tinyxml2::XMLElement *schedule_policy,
         else
             policy.period = std::atoi(value);
         policy.type = "periodic";
+        if (policy.pool)
+            COCO_FATAL() << "Activity executed by the pool cannot be periodic";
     }
     else
     {
@@ -812,6 +899,25 @@ void XmlParser::parseSchedule(tinyxml2::XMLElement *schedule_policy,
         COCO_FATAL() << "Realtime DEADLINE needs attribute runtime to be specified";
     }
 
+    const char *overrun = schedule_policy->Attribute("overrun");
+    if (overrun)
+    {
+        if (policy.type != "periodic")
+            COCO_FATAL() << "Overrun policy can be set only for periodic activities";
+        if (strcmp(overrun, "catch_up") == 0 ||
+            strcmp(overrun, "CATCH_UP") == 0)
+            policy.overrun = "catch_up";
+        else if (strcmp(overrun, "skip_next") == 0 ||
+                 strcmp(overrun, "SKIP_NEXT") == 0)
+            policy.overrun = "skip_next";
+        else if (strcmp(overrun, "phase_reset") == 0 ||
+                 strcmp(overrun, "PHASE_RESET") == 0)
+            policy.overrun = "phase_reset";
+        else
+            COCO_FATAL() << "Overrun policy: " << overrun << " is not know\n" <<
+                            "Possibilities are: catch_up, skip_next, phase_reset";
+    }
+
     policy.affinity = -1;
     policy.exclusive = false;
     const char *affinity = schedule_policy->Attribute("affinity");
@@ -899,6 +1005,21 @@ void XmlParser::createComponent(std::shared_ptr<TaskSpec> task_spec,
         attributes->InsertEndChild(attribute);
     }
 
+    if (!task_spec->ports.empty())
+    {
+        auto ports = xml_doc_.NewElement("ports");
+        component->InsertEndChild(ports);
+
+        for (auto &port_spec : task_spec->ports)
+        {
+            auto port = xml_doc_.NewElement("port");
+            port->SetAttribute("name", port_spec.name.c_str());
+            if (!port_spec.manager.empty())
+                port->SetAttribute("manager", port_spec.manager.c_str());
+            ports->InsertEndChild(port);
+        }
+    }
+
     auto peers = xml_doc_.NewElement("components");
     component->InsertEndChild(peers);
 
@@ -918,6 +1039,14 @@ void XmlParser::createConnection(std::unique_ptr<ConnectionSpec> &connection_spe
     connection->SetAttribute("policy", connection_spec->policy.policy.c_str());
     connection->SetAttribute("transport", connection_spec->policy.transport.c_str());
     connection->SetAttribute("buffersize", connection_spec->policy.buffersize.c_str());
+    if (!connection_spec->policy.name.empty())
+        connection->SetAttribute("name", connection_spec->policy.name.c_str());
+    if (connection_spec->policy.broadcast)
+        connection->SetAttribute("broadcast", true);
+    if (!connection_spec->policy.overflow.empty())
+        connection->SetAttribute("overflow", connection_spec->policy.overflow.c_str());
+    if (connection_spec->policy.overflow_timeout > 0)
+        connection->SetAttribute("overflow_timeout", connection_spec->policy.overflow_timeout);
 
     auto src = xml_doc_.NewElement("src");
     connection->InsertEndChild(src);
@@ -0,0 +1,1064 @@
+/**
+ * Project: CoCo
+ * Copyright (c) 2016, Scuola Superiore Sant'Anna
+ *
+ * Authors: Filippo Brizzi <fi.brizzi@sssup.it>, Emanuele Ruffaldi
+ *
+ * This file is subject to the terms and conditions defined in
+ * file 'LICENSE.txt', which is part of this source code package.
+ */
+
+#include <algorithm>
+#include <unordered_map>
+
+#include <coco/coco.h>
+
+/* Components used to benchmark the connections.
+ * Each sink prints the mean latency and the throughput every "samples" read values,
+ * so that connections with different policies can be compared in the same run.
+ */
+
+class BenchSource : public coco::TaskContext
+{
+public:
+    coco::OutputPort<int long> out_time_ = {this, "time_OUT"};
+    coco::Attribute<int> aburst_ = {this, "burst", burst_};
+
+    void init() {}
+    void onConfig() {}
+
+    void onUpdate()
+    {
+        for (int i = 0; i < burst_; ++i)
+            out_time_.write(coco::util::time());
+    }
+private:
+    int burst_ = 1;
+};
+
+COCO_REGISTER(BenchSource)
+
+class BenchSink : public coco::TaskContext
+{
+public:
+    coco::InputPort<int long> in_time_ = {this, "time_IN", true};
+    coco::Attribute<int> asamples_ = {this, "samples", samples_};
+
+    void init() {}
+    void onConfig()
+    {
+        start_time_ = coco::util::time();
+    }
+
+    void onUpdate()
+    {
+        int long time;
+        while (in_time_.read(time) == coco::NEW_DATA)
+        {
+            latency_ += coco::util::time() - time;
+            /* Values are written in increasing order, an older one means stale data */
+            if (time < last_time_)
+                ++stale_;
+            last_time_ = time;
+            if (++count_ < samples_)
+                continue;
+
+            auto now = coco::util::time();
+            COCO_LOG(1) << instantiationName() << " mean latency: "
+                        << static_cast<double>(latency_) / count_ << " us, throughput: "
+                        << count_ * 1000000.0 / (now - start_time_) << " samples/s, stale: "
+                        << stale_;
+            latency_ = 0;
+            count_ = 0;
+            stale_ = 0;
+            start_time_ = now;
+        }
+    }
+private:
+    int samples_ = 1000;
+    int count_ = 0;
+    int stale_ = 0;
+    int long latency_ = 0;
+    int long start_time_ = 0;
+    int long last_time_ = 0;
+};
+
+COCO_REGISTER(BenchSink)
+
+/* Large payload, used to compare OutputPort::write() with OutputPort::loan()/publish() */
+struct BenchFrame
+{
+    int long time = 0;
+    std::vector<unsigned char> data;
+};
+
+class BenchFrameSource : public coco::TaskContext
+{
+public:
+    coco::OutputPort<BenchFrame> out_frame_ = {this, "frame_OUT"};
+    coco::Attribute<int> asize_ = {this, "size", size_};
+    coco::Attribute<bool> aloan_ = {this, "loan", loan_};
+
+    void init() {}
+    void onConfig()
+    {
+        frame_.data.resize(size_);
+    }
+
+    void onUpdate()
+    {
+        if (loan_)
+        {
+            auto frame = out_frame_.loan();
+            frame->data.resize(size_);
+            frame->time = coco::util::time();
+            out_frame_.publish(frame);
+        }
+        else
+        {
+            frame_.time = coco::util::time();
+            out_frame_.write(frame_);
+        }
+    }
+private:
+    int size_ = 1 << 20;
+    bool loan_ = false;
+    BenchFrame frame_;
+};
+
+COCO_REGISTER(BenchFrameSource)
+
+class BenchFrameSink : public coco::TaskContext
+{
+public:
+    coco::InputPort<BenchFrame> in_frame_ = {this, "frame_IN", true};
+    coco::Attribute<int> asamples_ = {this, "samples", samples_};
+    coco::Attribute<bool> aloan_ = {this, "loan", loan_};
+
+    void init() {}
+    void onConfig()
+    {
+        start_time_ = coco::util::time();
+    }
+
+    void onUpdate()
+    {
+        if (loan_)
+        {
+            std::shared_ptr<const BenchFrame> frame;
+            while (in_frame_.read(frame) == coco::NEW_DATA)
+                addSample(frame->time);
+        }
+        else
+        {
+            while (in_frame_.read(frame_) == coco::NEW_DATA)
+                addSample(frame_.time);
+        }
+    }
+private:
+    void addSample(int long time)
+    {
+        latency_ += coco::util::time() - time;
+        if (++count_ < samples_)
+            return;
+
+        auto now = coco::util::time();
+        COCO_LOG(1) << instantiationName() << " mean latency: "
+                    << static_cast<double>(latency_) / count_ << " us, throughput: "
+                    << count_ * 1000000.0 / (now - start_time_) << " samples/s";
+        latency_ = 0;
+        count_ = 0;
+        start_time_ = now;
+    }
+
+    int samples_ = 100;
+    bool loan_ = false;
+    int count_ = 0;
+    int long latency_ = 0;
+    int long start_time_ = 0;
+    BenchFrame frame_;
+};
+
+COCO_REGISTER(BenchFrameSink)
+
+/* Payloads used to compare the copy and the move write paths */
+inline void makePayload(std::vector<double> &payload, int size)
+{
+    payload.assign(size, 1.0);
+}
+
+inline void makePayload(std::string &payload, int size)
+{
+    payload.assign(size, 'x');
+}
+
+/* Every step builds a new payload and writes it copying or moving it.
+ * Prints the mean time spent in write() every "samples" steps.
+ */
+template <class T>
+class BenchMoveSource : public coco::TaskContext
+{
+public:
+    coco::OutputPort<T> out_payload_ = {this, "payload_OUT"};
+    coco::Attribute<int> asize_ = {this, "size", size_};
+    coco::Attribute<bool> amove_ = {this, "move", move_};
+    coco::Attribute<int> asamples_ = {this, "samples", samples_};
+
+    void init() {}
+    void onConfig() {}
+
+    void onUpdate()
+    {
+        T payload;
+        makePayload(payload, size_);
+
+        auto start = coco::util::time();
+        if (move_)
+            out_payload_.write(std::move(payload));
+        else
+            out_payload_.write(payload);
+        write_time_ += coco::util::time() - start;
+
+        if (++count_ < samples_)
+            return;
+        COCO_LOG(1) << instantiationName() << " mean write time: "
+                    << static_cast<double>(write_time_) / count_ << " us";
+        write_time_ = 0;
+        count_ = 0;
+    }
+private:
+    int size_ = 100000;
+    bool move_ = false;
+    int samples_ = 1000;
+    int count_ = 0;
+    int long write_time_ = 0;
+};
+
+/* Reads all the incoming payloads and prints the mean time spent in read() every "samples" values. */
+template <class T>
+class BenchMoveSink : public coco::TaskContext
+{
+public:
+    coco::InputPort<T> in_payload_ = {this, "payload_IN", true};
+    coco::Attribute<int> asamples_ = {this, "samples", samples_};
+
+    void init() {}
+    void onConfig() {}
+
+    void onUpdate()
+    {
+        T payload;
+        auto start = coco::util::time();
+        while (in_payload_.read(payload) == coco::NEW_DATA)
+        {
+            read_time_ += coco::util::time() - start;
+            if (++count_ >= samples_)
+            {
+                COCO_LOG(1) << instantiationName() << " mean read time: "
+                            << static_cast<double>(read_time_) / count_ << " us";
+                read_time_ = 0;
+                count_ = 0;
+            }
+            start = coco::util::time();
+        }
+    }
+private:
+    int samples_ = 1000;
+    int count_ = 0;
+    int long read_time_ = 0;
+};
+
+using BenchVectorSource = BenchMoveSource<std::vector<double> >;
+using BenchVectorSink = BenchMoveSink<std::vector<double> >;
+using BenchStringSource = BenchMoveSource<std::string>;
+using BenchStringSink = BenchMoveSink<std::string>;
+
+COCO_REGISTER(BenchVectorSource)
+COCO_REGISTER(BenchVectorSink)
+COCO_REGISTER(BenchStringSource)
+COCO_REGISTER(BenchStringSink)
+
+/* Writes "burst" timestamps every step, "batch" at a time with OutputPort::writeBatch(),
+ * or one by one with OutputPort::write() when batch is 1.
+ * Prints the mean time spent writing a single value every "samples" values.
+ */
+class BenchBatchSource : public coco::TaskContext
+{
+public:
+    coco::OutputPort<int long> out_time_ = {this, "time_OUT"};
+    coco::Attribute<int> aburst_ = {this, "burst", burst_};
+    coco::Attribute<int> abatch_ = {this, "batch", batch_};
+    coco::Attribute<int> asamples_ = {this, "samples", samples_};
+
+    void init() {}
+    void onConfig()
+    {
+        if (batch_ < 1)
+            batch_ = 1;
+        times_.resize(burst_);
+    }
+
+    void onUpdate()
+    {
+        auto now = coco::util::time();
+        for (auto &time : times_)
+            time = now;
+
+        auto start = coco::util::time();
+        for (int i = 0; i < burst_; i += batch_)
+        {
+            if (batch_ == 1)
+                out_time_.write(times_[i]);
+            else
+                out_time_.writeBatch(&times_[i], std::min(batch_, burst_ - i));
+        }
+        write_time_ += coco::util::time() - start;
+
+        count_ += burst_;
+        if (count_ < samples_)
+            return;
+        COCO_LOG(1) << instantiationName() << " mean write time: "
+                    << static_cast<double>(write_time_) * 1000.0 / count_ << " ns";
+        write_time_ = 0;
+        count_ = 0;
+    }
+private:
+    int burst_ = 1000;
+    int batch_ = 1;
+    int samples_ = 100000;
+    int count_ = 0;
+    int long write_time_ = 0;
+    std::vector<int long> times_;
+};
+
+COCO_REGISTER(BenchBatchSource)
+
+/* Reads "batch" values at a time with InputPort::readN() in a preallocated array,
+ * or one by one with InputPort::read() when batch is 1.
+ * With "once" set it reads a single time for each execution, relying on the triggers to be executed again.
+ * Prints the mean latency and the throughput every "samples" values.
+ */
+class BenchBatchSink : public coco::TaskContext
+{
+public:
+    coco::InputPort<int long> in_time_ = {this, "time_IN", true};
+    coco::Attribute<int> abatch_ = {this, "batch", batch_};
+    coco::Attribute<int> asamples_ = {this, "samples", samples_};
+    coco::Attribute<int> aonce_ = {this, "once", once_};
+
+    void init() {}
+    void onConfig()
+    {
+        if (batch_ < 1)
+            batch_ = 1;
+        times_.resize(batch_);
+        start_time_ = coco::util::time();
+    }
+
+    void onUpdate()
+    {
+        if (batch_ == 1)
+        {
+            while (in_time_.read(times_[0]) == coco::NEW_DATA)
+            {
+                addSamples(1);
+                if (once_)
+                    break;
+            }
+        }
+        else
+        {
+            unsigned int count;
+            while ((count = in_time_.readN(times_.data(), batch_)) > 0)
+            {
+                addSamples(count);
+                if (once_)
+                    break;
+            }
+        }
+    }
+private:
+    void addSamples(unsigned int count)
+    {
+        auto now = coco::util::time();
+        for (unsigned int i = 0; i < count; ++i)
+            latency_ += now - times_[i];
+        count_ += count;
+        if (count_ < samples_)
+            return;
+
+        COCO_LOG(1) << instantiationName() << " mean latency: "
+                    << static_cast<double>(latency_) / count_ << " us, throughput: "
+                    << count_ * 1000000.0 / (now - start_time_) << " samples/s";
+        latency_ = 0;
+        count_ = 0;
+        start_time_ = now;
+    }
+
+    int batch_ = 1;
+    int samples_ = 100000;
+    int once_ = 0;
+    int count_ = 0;
+    int long latency_ = 0;
+    int long start_time_ = 0;
+    std::vector<int long> times_;
+};
+
+COCO_REGISTER(BenchBatchSink)
+
+/* Periodic sink that either polls its port once per period or, when "wait" is set, blocks on
+ * InputPort::readUntil() for the first "budget" milliseconds of the period.
+ * Prints the mean latency every "samples" values.
+ */
+class BenchWaitSink : public coco::TaskContext
+{
+public:
+    coco::InputPort<int long> in_time_ = {this, "time_IN"};
+    coco::Attribute<bool> await_ = {this, "wait", wait_};
+    coco::Attribute<int> abudget_ = {this, "budget", budget_};
+    coco::Attribute<int> asamples_ = {this, "samples", samples_};
+
+    void init() {}
+    void onConfig() {}
+
+    void onUpdate()
+    {
+        int long time;
+        if (wait_)
+        {
+            auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(budget_);
+            while (in_time_.readUntil(time, deadline) == coco::NEW_DATA)
+                addSample(time);
+        }
+        else
+        {
+            while (in_time_.read(time) == coco::NEW_DATA)
+                addSample(time);
+        }
+    }
+private:
+    void addSample(int long time)
+    {
+        latency_ += coco::util::time() - time;
+        if (++count_ < samples_)
+            return;
+
+        COCO_LOG(1) << instantiationName() << " mean latency: "
+                    << static_cast<double>(latency_) / count_ << " us";
+        latency_ = 0;
+        count_ = 0;
+    }
+
+    bool wait_ = false;
+    int budget_ = 9;
+    int samples_ = 100;
+    int count_ = 0;
+    int long latency_ = 0;
+};
+
+COCO_REGISTER(BenchWaitSink)
+
+/* Slow sink, sleeps "delay" us for each value read so that the connection overflows.
+ * Prints the overflow counters of its port every "samples" values.
+ */
+class BenchOverflowSink : public coco::TaskContext
+{
+public:
+    coco::InputPort<int long> in_time_ = {this, "time_IN", true};
+    coco::Attribute<int> adelay_ = {this, "delay", delay_};
+    coco::Attribute<int> asamples_ = {this, "samples", samples_};
+
+    void init() {}
+    void onConfig() {}
+
+    void onUpdate()
+    {
+        int long time;
+        while (in_time_.read(time) == coco::NEW_DATA)
+        {
+            std::this_thread::sleep_for(std::chrono::microseconds(delay_));
+            if (++count_ < samples_)
+                continue;
+
+            COCO_LOG(1) << instantiationName() << " dropped: " << in_time_.droppedCount()
+                        << ", blocked: " << in_time_.blockedTime() << " us, high water: "
+                        << in_time_.highWaterMark();
+            count_ = 0;
+        }
+    }
+private:
+    int delay_ = 100;
+    int samples_ = 1000;
+    int count_ = 0;
+};
+
+COCO_REGISTER(BenchOverflowSink)
+
+/* Uses the header written with each sample to measure the latency of the edge
+ * and to count the samples lost in the connection.
+ */
+class BenchInfoSink : public coco::TaskContext
+{
+public:
+    coco::InputPort<int long> in_time_ = {this, "time_IN", true};
+    coco::Attribute<int> adelay_ = {this, "delay", delay_};
+    coco::Attribute<int> asamples_ = {this, "samples", samples_};
+
+    void init() {}
+    void onConfig() {}
+
+    void onUpdate()
+    {
+        int long time;
+        coco::SampleInfo info;
+        while (in_time_.read(time, info) == coco::NEW_DATA)
+        {
+            latency_ += coco::util::monotonicTime() - info.timestamp;
+            if (last_sequence_ > 0)
+                lost_ += info.sequence - last_sequence_ - 1;
+            last_sequence_ = info.sequence;
+            std::this_thread::sleep_for(std::chrono::microseconds(delay_));
+            if (++count_ < samples_)
+                continue;
+
+            COCO_LOG(1) << instantiationName() << " mean latency: "
+                        << static_cast<double>(latency_) / count_ << " us, lost: " << lost_;
+            latency_ = 0;
+            lost_ = 0;
+            count_ = 0;
+        }
+    }
+private:
+    int delay_ = 100;
+    int samples_ = 1000;
+    int count_ = 0;
+    int long latency_ = 0;
+    uint64_t lost_ = 0;
+    uint64_t last_sequence_ = 0;
+};
+
+COCO_REGISTER(BenchInfoSink)
+
+/* Measure the cost of a single write and read call on a port, the values are written
+ * and read in a tight loop of "burst" calls. Each component prints the mean time of
+ * one call every "samples" executions.
+ */
+class BenchCallSource : public coco::TaskContext
+{
+public:
+    coco::OutputPort<int> out_value_ = {this, "value_OUT"};
+    coco::Attribute<int> aburst_ = {this, "burst", burst_};
+    coco::Attribute<int> asamples_ = {this, "samples", samples_};
+
+    void init() {}
+    void onConfig() {}
+
+    void onUpdate()
+    {
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < burst_; ++i)
+            out_value_.write(i);
+        elapsed_ += std::chrono::steady_clock::now() - start;
+        if (++count_ < samples_)
+            return;
+
+        COCO_LOG(1) << instantiationName() << " write: "
+                    << std::chrono::duration<double, std::nano>(elapsed_).count() / (count_ * burst_)
+                    << " ns/op";
+        elapsed_ = std::chrono::steady_clock::duration::zero();
+        count_ = 0;
+    }
+private:
+    int burst_ = 10000;
+    int samples_ = 100;
+    int count_ = 0;
+    std::chrono::steady_clock::duration elapsed_ = std::chrono::steady_clock::duration::zero();
+};
+
+COCO_REGISTER(BenchCallSource)
+
+class BenchCallSink : public coco::TaskContext
+{
+public:
+    coco::InputPort<int> in_value_ = {this, "value_IN"};
+    coco::Attribute<int> aburst_ = {this, "burst", burst_};
+    coco::Attribute<int> asamples_ = {this, "samples", samples_};
+
+    void init() {}
+    void onConfig() {}
+
+    void onUpdate()
+    {
+        int value;
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < burst_; ++i)
+            in_value_.read(value);
+        elapsed_ += std::chrono::steady_clock::now() - start;
+        if (++count_ < samples_)
+            return;
+
+        COCO_LOG(1) << instantiationName() << " read: "
+                    << std::chrono::duration<double, std::nano>(elapsed_).count() / (count_ * burst_)
+                    << " ns/op";
+        elapsed_ = std::chrono::steady_clock::duration::zero();
+        count_ = 0;
+    }
+private:
+    int burst_ = 10000;
+    int samples_ = 100;
+    int count_ = 0;
+    std::chrono::steady_clock::duration elapsed_ = std::chrono::steady_clock::duration::zero();
+};
+
+COCO_REGISTER(BenchCallSink)
+
+/* Forwards all the timestamps it reads, used to build long pipelines */
+class BenchStage : public coco::TaskContext
+{
+public:
+    coco::InputPort<int long> in_time_ = {this, "time_IN", true};
+    coco::OutputPort<int long> out_time_ = {this, "time_OUT"};
+
+    void init() {}
+    void onConfig() {}
+
+    void onUpdate()
+    {
+        int long time;
+        while (in_time_.read(time) == coco::NEW_DATA)
+            out_time_.write(time);
+    }
+};
+
+COCO_REGISTER(BenchStage)
+
+/* Reads one timestamp for each execution and forwards it after a random time up to "delay" us.
+ * Used as a pool of workers reading from a WORK_QUEUE connection, the sink receives each timestamp once.
+ */
+class BenchWorkQueueWorker : public coco::TaskContext
+{
+public:
+    coco::InputPort<int long> in_time_ = {this, "time_IN", true};
+    coco::OutputPort<int long> out_time_ = {this, "time_OUT"};
+    coco::Attribute<int> adelay_ = {this, "delay", delay_};
+
+    void init() {}
+    void onConfig() {}
+
+    void onUpdate()
+    {
+        int long time;
+        if (in_time_.read(time) != coco::NEW_DATA)
+            return;
+        std::this_thread::sleep_for(std::chrono::microseconds(random() % delay_));
+        out_time_.write(time);
+    }
+private:
+    int delay_ = 1000;
+};
+
+COCO_REGISTER(BenchWorkQueueWorker)
+
+/* Farm benchmark. The source dispatches an increasing counter, the workers need a random
+ * time to process each value and the gather checks the order in which the results arrive
+ * and their latency since the dispatch.
+ */
+class BenchFarmSource : public coco::TaskContext
+{
+public:
+    coco::OutputPort<int> out_value_ = {this, "value_OUT"};
+    coco::Attribute<int> asamples_ = {this, "samples", samples_};
+    coco::Attribute<int> aphase_ = {this, "phase", phase_};
+    coco::Attribute<int> aburst_ = {this, "burst", burst_};
+
+    void init() {}
+    void onConfig() {}
+    /* With a phase the rate alternates every "phase" steps between one burst per step and one every ten */
+    void onUpdate()
+    {
+        ++step_;
+        if (phase_ > 0 && (step_ / phase_) % 2 == 1 && step_ % 10 != 0)
+            return;
+        for (int i = 0; i < burst_; ++i)
+        {
+            if (!out_value_.write(++value_))
+                ++rejected_;
+            if (value_ % samples_ == 0)
+                report();
+        }
+    }
+private:
+    void report()
+    {
+        auto farm = out_value_.farmStatistics();
+        COCO_LOG(1) << instantiationName() << " rejected: " << rejected_
+                    << ", workers: " << farm.workers << "/" << farm.max_workers
+                    << ", scale up: " << farm.scale_up << ", scale down: " << farm.scale_down
+                    << ", speculated: " << farm.speculated << ", duplicates: " << farm.duplicates;
+        rejected_ = 0;
+    }
+
+    int samples_ = 1000;
+    int phase_ = 0;
+    int burst_ = 1;
+    int step_ = 0;
+    int value_ = 0;
+    int rejected_ = 0;
+};
+
+COCO_REGISTER(BenchFarmSource)
+
+class BenchFarmWorker : public coco::TaskContext
+{
+public:
+    coco::InputPort<int> in_value_ = {this, "value_IN", true};
+    coco::OutputPort<int> out_value_ = {this, "value_OUT"};
+    coco::Attribute<int> adelay_ = {this, "delay", delay_};
+    coco::Attribute<int> aslowdown_ = {this, "slowdown", slowdown_};
+    coco::Attribute<int> adrop_ = {this, "drop", drop_};
+
+    void init() {}
+    /* Each worker is up to "slowdown" times slower than the fastest */
+    void onConfig()
+    {
+        factor_ = 1 + random() % slowdown_;
+    }
+    /* One value for each execution, the task is triggered again for the queued ones */
+    void onUpdate()
+    {
+        int value;
+        if (in_value_.read(value) != coco::NEW_DATA)
+            return;
+        /* With "drop" one value every "drop" is lost, as an item the worker fails */
+        if (drop_ > 0 && ++count_ % drop_ == 0)
+            return;
+        /* Once in a while a worker gets stuck */
+        int delay = random() % delay_ * factor_;
+        if (random() % 50 == 0)
+            delay *= 20;
+        std::this_thread::sleep_for(std::chrono::microseconds(delay));
+        out_value_.write(value);
+    }
+private:
+    int delay_ = 3000;
+    int slowdown_ = 1;
+    int drop_ = 0;
+    int count_ = 0;
+    int factor_ = 1;
+};
+
+COCO_REGISTER(BenchFarmWorker)
+
+/* Prints the latency of the results every "samples" values. With "once" it reads a single result
+ * per execution, so each result must keep its own trigger also in the reorder buffer of the gather. */
+class BenchFarmGather : public coco::TaskContext
+{
+public:
+    coco::InputPort<int> in_value_ = {this, "value_IN", true};
+    coco::Attribute<int> asamples_ = {this, "samples", samples_};
+    coco::Attribute<int> aonce_ = {this, "once", once_};
+
+    void init() {}
+    void onConfig() {}
+
+    void onUpdate()
+    {
+        int value;
+        coco::SampleInfo info;
+        while (in_value_.read(value, info) == coco::NEW_DATA)
+        {
+            if (value < last_)
+                ++out_of_order_;
+            last_ = value;
+            latencies_.push_back(coco::util::monotonicTime() - info.farm.timestamp);
+            if (static_cast<int>(latencies_.size()) >= samples_)
+                report();
+            if (once_)
+                break;
+        }
+    }
+private:
+    void report()
+    {
+        std::sort(latencies_.begin(), latencies_.end());
+        double mean = 0;
+        for (auto latency : latencies_)
+            mean += latency;
+        COCO_LOG(1) << instantiationName() << " latency mean: " << mean / latencies_.size()
+                    << " us, p50: " << latencies_[latencies_.size() / 2]
+                    << " us, p99: " << latencies_[latencies_.size() * 99 / 100]
+                    << " us, max: " << latencies_.back()
+                    << " us, out of order: " << out_of_order_
+                    << ", reordered: " << in_value_.reorderedCount()
+                    << ", discarded: " << in_value_.discardedCount();
+        latencies_.clear();
+        out_of_order_ = 0;
+    }
+
+    int samples_ = 500;
+    int once_ = 0;
+    int last_ = 0;
+    int out_of_order_ = 0;
+    std::vector<int long> latencies_;
+};
+
+COCO_REGISTER(BenchFarmGather)
+
+/* Item referring to an object whose state is kept by the farm workers */
+struct BenchKeyItem
+{
+    int object = 0;
+    int long time = 0;  // Time in ns spent by the worker on the object state
+    int key() const { return object; }
+};
+
+class BenchKeySource : public coco::TaskContext
+{
+public:
+    coco::OutputPort<BenchKeyItem> out_item_ = {this, "item_OUT"};
+    coco::Attribute<int> aobjects_ = {this, "objects", objects_};
+    coco::Attribute<int> asamples_ = {this, "samples", samples_};
+
+    void init() {}
+    void onConfig() {}
+
+    void onUpdate()
+    {
+        BenchKeyItem item;
+        item.object = random() % objects_;
+        out_item_.write(item);
+        if (++count_ % samples_ != 0)
+            return;
+
+        auto farm = out_item_.farmStatistics();
+        COCO_LOG(1) << instantiationName() << " rejected: " << farm.rejected
+                    << ", key spilled: " << farm.key_spilled;
+    }
+private:
+    int objects_ = 32;
+    int samples_ = 2000;
+    int count_ = 0;
+};
+
+COCO_REGISTER(BenchKeySource)
+
+/* Keeps "state" bytes for each object it receives and reads them all for each item */
+class BenchKeyWorker : public coco::TaskContext
+{
+public:
+    coco::InputPort<BenchKeyItem> in_item_ = {this, "item_IN", true};
+    coco::OutputPort<BenchKeyItem> out_item_ = {this, "item_OUT"};
+    coco::Attribute<int> astate_ = {this, "state", state_};
+
+    void init() {}
+    void onConfig() {}
+
+    void onUpdate()
+    {
+        BenchKeyItem item;
+        while (in_item_.read(item) == coco::NEW_DATA)
+        {
+            if (state_ > 0)
+            {
+                auto start = std::chrono::steady_clock::now();
+                auto &state = objects_[item.object];
+                if (state.empty())
+                    state.resize(state_);
+                for (unsigned int i = 0; i < state.size(); i += 64)
+                    ++state[i];
+                item.time = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                        std::chrono::steady_clock::now() - start).count();
+            }
+            out_item_.write(item);
+        }
+    }
+    void stop()
+    {
+        if (state_ > 0)
+            COCO_LOG(1) << instantiationName() << " objects: " << objects_.size();
+    }
+private:
+    int state_ = 0;
+    std::unordered_map<int, std::vector<unsigned char> > objects_;
+};
+
+COCO_REGISTER(BenchKeyWorker)
+
+class BenchKeyGather : public coco::TaskContext
+{
+public:
+    coco::InputPort<BenchKeyItem> in_item_ = {this, "item_IN", true};
+    coco::Attribute<int> asamples_ = {this, "samples", samples_};
+
+    void init() {}
+    void onConfig() {}
+
+    void onUpdate()
+    {
+        BenchKeyItem item;
+        while (in_item_.read(item) == coco::NEW_DATA)
+        {
+            time_ += item.time;
+            if (++count_ < samples_)
+                continue;
+            COCO_LOG(1) << instantiationName() << " state access mean: " << time_ / count_ << " ns";
+            time_ = 0;
+            count_ = 0;
+        }
+    }
+private:
+    int samples_ = 2000;
+    int count_ = 0;
+    int long time_ = 0;
+};
+
+COCO_REGISTER(BenchKeyGather)
+
+/* Farm reduction benchmark. Each worker turns a value in a histogram, the gather sums all of them.
+ * With a reduction tree the sums are computed by the reducers and the gather receives one
+ * partial histogram for many values.
+ */
+struct BenchHistogram
+{
+    int long count = 0;  // Values summed in the histogram
+    std::vector<uint32_t> bins;
+};
+
+static void combineHistogram(BenchHistogram &partial, const BenchHistogram &value)
+{
+    if (partial.bins.size() < value.bins.size())
+        partial.bins.resize(value.bins.size());
+    for (unsigned int i = 0; i < value.bins.size(); ++i)
+        partial.bins[i] += value.bins[i];
+    partial.count += value.count;
+}
+
+COCO_FARM_REDUCER(BenchHistogram, combineHistogram, BenchHistogramReducer)
+
+class BenchHistogramWorker : public coco::TaskContext
+{
+public:
+    coco::InputPort<int> in_value_ = {this, "value_IN", true};
+    coco::OutputPort<BenchHistogram> out_histogram_ = {this, "histogram_OUT"};
+    coco::Attribute<int> abins_ = {this, "bins", bins_};
+
+    void init() {}
+    void onConfig() {}
+
+    void onUpdate()
+    {
+        int value;
+        while (in_value_.read(value) == coco::NEW_DATA)
+        {
+            BenchHistogram histogram;
+            histogram.count = 1;
+            histogram.bins.resize(bins_);
+            for (int i = 0; i < 16; ++i)
+                ++histogram.bins[(value * 31 + i) % bins_];
+            out_histogram_.write(histogram);
+        }
+    }
+private:
+    int bins_ = 1024;
+};
+
+COCO_REGISTER(BenchHistogramWorker)
+
+class BenchHistogramPost : public coco::TaskContext
+{
+public:
+    coco::InputPort<BenchHistogram> in_histogram_ = {this, "histogram_IN", true};
+    coco::OutputPort<BenchHistogram> out_histogram_ = {this, "histogram_OUT"};
+
+    void init() {}
+    void onConfig() {}
+
+    void onUpdate()
+    {
+        BenchHistogram histogram;
+        while (in_histogram_.read(histogram) == coco::NEW_DATA)
+            out_histogram_.write(histogram);
+    }
+};
+
+COCO_REGISTER(BenchHistogramPost)
+
+class BenchHistogramGather : public coco::TaskContext
+{
+public:
+    coco::InputPort<BenchHistogram> in_histogram_ = {this, "histogram_IN", true};
+    coco::Attribute<int> asamples_ = {this, "samples", samples_};
+
+    void init() {}
+    void onConfig() {}
+
+    void onUpdate()
+    {
+        BenchHistogram histogram;
+        while (in_histogram_.read(histogram) == coco::NEW_DATA)
+        {
+            ++reads_;
+            combineHistogram(total_, histogram);
+            if (total_.count < samples_)
+                continue;
+
+            auto now = coco::util::monotonicTime();
+            if (start_ > 0)
+                COCO_LOG(1) << instantiationName() << " values/s: " << total_.count * 1000000.0 / (now - start_)
+                            << ", values per read: " << static_cast<double>(total_.count) / reads_;
+            start_ = now;
+            total_.count = 0;
+            reads_ = 0;
+        }
+    }
+private:
+    int samples_ = 5000;
+    int reads_ = 0;
+    int long start_ = 0;
+    BenchHistogram total_;
+};
+
+COCO_REGISTER(BenchHistogramGather)
+
+/* Periodic task that every "every" steps takes "delay" us, longer than its period, and counts
+ * the deadline misses notified by the activity. Writes a timestamp each step, so the sink
+ * throughput shows how many periods the overrun policy of the activity executes.
+ */
+class BenchOverrun : public coco::TaskContext
+{
+public:
+    coco::OutputPort<int long> out_time_ = {this, "time_OUT"};
+    coco::Attribute<int> adelay_ = {this, "delay", delay_};
+    coco::Attribute<int> aevery_ = {this, "every", every_};
+    coco::Attribute<int> asamples_ = {this, "samples", samples_};
+
+    void init() {}
+    void onConfig() {}
+
+    void onUpdate()
+    {
+        out_time_.write(coco::util::time());
+        if (++step_ % every_ == 0)
+            std::this_thread::sleep_for(std::chrono::microseconds(delay_));
+        if (step_ % samples_ == 0)
+        {
+            COCO_LOG(1) << instantiationName() << " steps: " << step_ << ", deadline misses: "
+                        << misses_ << ", max overrun: " << overrun_max_ * 1000 << " ms";
+        }
+    }
+
+    void onDeadlineMiss(double overrun)
+    {
+        ++misses_;
+        overrun_max_ = std::max(overrun, overrun_max_);
+    }
+private:
+    int delay_ = 12000;
+    int every_ = 50;
+    int samples_ = 400;
+    int step_ = 0;
+    int misses_ = 0;
+    double overrun_max_ = 0;
+};
+
+COCO_REGISTER(BenchOverrun)
@@ -187,6 +187,16 @@ function ui() {
 		tableStatsAPI.clear();
 		tableStatsAPI.rows.add(json.stats);
 		tableStatsAPI.draw();
+	}else if (selectedTab == "#tabs-connections")
+	{
+		tableConnectionsAPI.clear();
+		tableConnectionsAPI.rows.add(json.connections);
+		tableConnectionsAPI.draw();
+	}else if (selectedTab == "#tabs-farms")
+	{
+		tableFarmsAPI.clear();
+		tableFarmsAPI.rows.add(json.farms);
+		tableFarmsAPI.draw();
 	}else if (selectedTab == "#tabs-graphs")
 	{
 		plots(json.stats);
@@ -259,7 +269,11 @@ $(function() {
 			{ "data": "active" },
 			{ "data": "periodic" },
 			{ "data": "period" },
-			{ "data": "policy" }
+			{ "data": "policy" },
+			{ "data": "overrun" },
+			{ "data": "misses" },
+			{ "data": "overrun_max" },
+			{ "data": "overrun_histogram" }
 		],
 		"select": "single",
 		"scrollY": "500px",
@@ -296,7 +310,10 @@ $(function() {
 			{ "data": "time_exec_mean" },
 			{ "data": "time_exec_stddev" },
 			{ "data": "time_min" },
-			{ "data": "time_max" }
+			{ "data": "time_max" },
+			{ "data": "jitter_mean" },
+			{ "data": "jitter_max" },
+			{ "data": "drift" }
 		],
 		"select": "single",
 		"scrollY": "500px",
@@ -307,6 +324,50 @@ $(function() {
 	});
 	tableStatsAPI = $("#table-stats").dataTable().api();
 
+	tableConnections = $("#table-connections").DataTable({
+		"columns": [
+			{ "data": "src" },
+			{ "data": "dest" },
+			{ "data": "written" },
+			{ "data": "read" },
+			{ "data": "bytes" },
+			{ "data": "dropped" },
+			{ "data": "blocked_time" },
+			{ "data": "queue_length" },
+			{ "data": "high_water" },
+			{ "data": "since_last_write" }
+		],
+		"select": "single",
+		"scrollY": "500px",
+  		"scrollCollapse": true,
+  		"paging": false
+	});
+	tableConnectionsAPI = $("#table-connections").dataTable().api();
+
+	tableFarms = $("#table-farms").DataTable({
+		"columns": [
+			{ "data": "src" },
+			{ "data": "workers" },
+			{ "data": "min_workers" },
+			{ "data": "max_workers" },
+			{ "data": "rejected" },
+			{ "data": "key_spilled" },
+			{ "data": "scale_up" },
+			{ "data": "scale_down" },
+			{ "data": "since_last_scale" },
+			{ "data": "dispatched" },
+			{ "data": "speculated" },
+			{ "data": "duplicates" },
+			{ "data": "latency_p50" },
+			{ "data": "latency_p99" }
+		],
+		"select": "single",
+		"scrollY": "500px",
+  		"scrollCollapse": true,
+  		"paging": false
+	});
+	tableFarmsAPI = $("#table-farms").dataTable().api();
+
 	selectedTab = "";
 	$("#tabs").tabs({
 		heightStyle: "fill",